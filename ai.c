@@ -1,70 +1,470 @@
 #include "ai.h"
 #include "game.h"
-#include <limits.h>
+#include "metrics.h"
+#include "timer.h"
+#include <pthread.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
-static int evaluate_board(const char board[9], char ai, char human) {
-    char w = check_winner(board);
-    if (w == ai) return 10;
-    if (w == human) return -10;
+/* Search runs on bitboards as an alpha-beta negamax: `me` holds the stones
+   of the side to move, `opp` those of the side that just moved. Scores are
+   +/-(WIN_SCORE - depth) so faster wins and slower losses are preferred,
+   exactly as the original minimax scored them. */
+
+#define WIN_SCORE 10
+#define INF 1000
+
+/* Center first, then corners, then edges */
+static const int move_order[9] = { 4, 0, 2, 6, 8, 1, 3, 5, 7 };
+
+/* Zobrist keys: one per (symbol, cell), [0] for X and [1] for O, plus one
+   toggled when X is to move */
+static const uint64_t zobrist[2][9] = {
+    { 0xC0E16B163A85A4DCULL, 0x890ACD8DD443C47CULL, 0xB3889D8A6DC47761ULL,
+      0x6A0398E528F0AE6AULL, 0x048344ECE48A855EULL, 0xF175CFEA21871330ULL,
+      0x391CEEF02702C2FDULL, 0x4BAF8CAC4784CB12ULL, 0x3547744583A3F88EULL },
+    { 0xD9CF2B15C6B6C90EULL, 0x961FACC76D5FE21CULL, 0x0094AB49D50F11F9ULL,
+      0xE3211E37BDBEB6DCULL, 0x62FE6C274FF3511AULL, 0x5AC30B329FDF0574ULL,
+      0x1450582C6B65B406ULL, 0x7A30FCC7888EB791ULL, 0x5540F5BA6A15576EULL }
+};
+static const uint64_t zobrist_x_to_move = 0x16CEF0559096D3E9ULL;
+
+/* Transposition table. Values are stored relative to the node (as if it
+   were at depth 0) so entries stay valid when later get_best_move calls
+   reach the same position at a different depth.
+
+   Searches on several threads share the table without locks: an entry
+   holds its packed fields and key ^ fields, each written as one 64-bit
+   word, so a read that sees half of a concurrent write fails the key
+   check and counts as a miss. */
+enum { TT_EMPTY = 0, TT_EXACT, TT_LOWER, TT_UPPER };
+
+typedef struct {
+    uint64_t check;     /* key ^ data */
+    uint64_t data;      /* value | bound << 8 | move << 16 | draft << 24 */
+} TTEntry;
+
+/* An entry's fields, unpacked */
+typedef struct {
+    int value;
+    int bound;
+    int move;
+    int draft;          /* empty cells below the node when stored */
+} TTData;
+
+#define TT_DEFAULT_ENTRIES (1u << 13)   /* comfortably above the 5,478 positions */
+
+static TTEntry tt_builtin[TT_DEFAULT_ENTRIES];
+static TTEntry *tt = tt_builtin;
+static size_t tt_mask = TT_DEFAULT_ENTRIES - 1;
+static TTReplace tt_policy = TT_REPLACE_DEPTH;
+
+int ai_tt_configure(size_t bytes, TTReplace policy) {
+    TTEntry *table = tt_builtin;
+    size_t entries = TT_DEFAULT_ENTRIES;
+    if (bytes > 0) {
+        entries = 1;
+        while (entries * 2 * sizeof(TTEntry) <= bytes) entries *= 2;
+        table = calloc(entries, sizeof(TTEntry));
+        if (!table) return -1;
+    }
+    if (tt != tt_builtin) free(tt);
+    tt = table;
+    tt_mask = entries - 1;
+    tt_policy = policy;
+    ai_tt_clear();
     return 0;
 }
 
-static int minimax(char board[9], char ai, char human, int depth, bool isMax) {
-    int score = evaluate_board(board, ai, human);
-    if (score == 10) return score - depth; /* prefer faster wins */
-    if (score == -10) return score + depth; /* prefer slower losses */
+void ai_tt_clear(void) {
+    memset(tt, 0, (tt_mask + 1) * sizeof(TTEntry));
+}
 
-    /* tie */
-    bool movesLeft = false;
-    for (int i = 0; i < 9; ++i) if (board[i] == ' ') { movesLeft = true; break; }
-    if (!movesLeft) return 0;
+static int tt_to_node(int v, int depth) {
+    return v > 0 ? v + depth : v < 0 ? v - depth : 0;
+}
 
-    if (isMax) {
-        int best = INT_MIN;
-        for (int i = 0; i < 9; ++i) {
-            if (board[i] == ' ') {
-                board[i] = ai;
-                int val = minimax(board, ai, human, depth+1, false);
-                board[i] = ' ';
-                if (val > best) best = val;
+static int tt_from_node(int v, int depth) {
+    return v > 0 ? v - depth : v < 0 ? v + depth : 0;
+}
+
+/* Fills `d` and returns 1 if the table holds `key` */
+static int tt_load(uint64_t key, TTData *d) {
+    TTEntry *e = &tt[key & tt_mask];
+    uint64_t data = __atomic_load_n(&e->data, __ATOMIC_RELAXED);
+    uint64_t check = __atomic_load_n(&e->check, __ATOMIC_RELAXED);
+    d->bound = (int)((data >> 8) & 0xFF);
+    if (d->bound == TT_EMPTY || (check ^ data) != key) return 0;
+    d->value = (signed char)(data & 0xFF);
+    d->move = (signed char)((data >> 16) & 0xFF);
+    d->draft = (int)((data >> 24) & 0xFF);
+    return 1;
+}
+
+static void tt_store(uint64_t key, int value, int bound, int move, int draft, int depth) {
+    TTEntry *e = &tt[key & tt_mask];
+    if (tt_policy == TT_REPLACE_DEPTH) {
+        uint64_t old = __atomic_load_n(&e->data, __ATOMIC_RELAXED);
+        uint64_t check = __atomic_load_n(&e->check, __ATOMIC_RELAXED);
+        if (((old >> 8) & 0xFF) != TT_EMPTY && (check ^ old) != key && (int)((old >> 24) & 0xFF) > draft)
+            return;
+    }
+    uint64_t data = (uint64_t)(unsigned char)tt_to_node(value, depth)
+                  | (uint64_t)bound << 8
+                  | (uint64_t)(unsigned char)move << 16
+                  | (uint64_t)draft << 24;
+    __atomic_store_n(&e->data, data, __ATOMIC_RELAXED);
+    __atomic_store_n(&e->check, key ^ data, __ATOMIC_RELAXED);
+}
+
+/* Empty cells that would complete a line for `me` */
+static Bitboard threat_cells(Bitboard me, Bitboard opp) {
+    Bitboard t = 0;
+    for (int i = 0; i < 8; ++i) {
+        if (win_masks[i] & opp) continue;
+        Bitboard rest = (Bitboard)(win_masks[i] & ~me);
+        if (rest && !(rest & (rest - 1))) t |= rest;
+    }
+    return t;
+}
+
+/* Zobrist keys of the position under each of the 8 symmetries. The
+   smallest one names the canonical orientation, so all symmetric variants
+   of a position share one table entry. */
+typedef struct { uint64_t k[8]; } SymKeys;
+
+static void keys_play(const SymKeys *from, SymKeys *to, int side, int cell) {
+    for (int t = 0; t < 8; ++t)
+        to->k[t] = from->k[t] ^ zobrist[side][sym_perm[t][cell]] ^ zobrist_x_to_move;
+}
+
+/* Symmetries (other than identity) leaving me/opp unchanged, as a bit set */
+static unsigned stabilizer(Bitboard me, Bitboard opp, const SymKeys *keys) {
+    unsigned stab = 0;
+    for (int t = 1; t < 8; ++t)
+        if (keys->k[t] == keys->k[0] && bits_transform(me, t) == me && bits_transform(opp, t) == opp)
+            stab |= 1u << t;
+    return stab;
+}
+
+/* Per-call search state */
+typedef struct {
+    unsigned long nodes;
+    unsigned long cutoffs;
+    unsigned long tt_hits;
+    int max_depth;
+    uint64_t deadline_ns;   /* 0 = no time limit */
+    int horizon;            /* set when the depth limit cut a line short */
+    int aborted;            /* set when the deadline passed; results are void */
+    int no_tt;              /* leave the shared transposition table alone */
+} SearchCtx;
+
+static int bit_count(Bitboard m) {
+    int n = 0;
+    for (; m; m &= (Bitboard)(m - 1)) ++n;
+    return n;
+}
+
+/* `side` is 0 when `me` plays X, 1 when `me` plays O; `keys` hash the
+   position including the side to move. At most `left` more plies are
+   searched; positions beyond that score 0. */
+static int negamax(SearchCtx *ctx, Bitboard me, Bitboard opp, int side, const SymKeys *keys,
+                   int last, int depth, int left, int alpha, int beta) {
+    ctx->nodes++;
+    if (depth + 1 > ctx->max_depth) ctx->max_depth = depth + 1;
+    if (ctx->deadline_ns && (ctx->nodes & 255) == 0 && timer_now_ns() >= ctx->deadline_ns)
+        ctx->aborted = 1;
+    if (ctx->aborted) return 0;
+
+    if (bits_line_through(opp, last)) return -(WIN_SCORE - depth);
+
+    Bitboard empty = (Bitboard)(~(me | opp) & BOARD_FULL);
+    if (!empty) return 0; /* tie */
+
+    /* A winning move is the best any move can do */
+    if (threat_cells(me, opp)) return WIN_SCORE - (depth + 1);
+
+    if (left == 0) {
+        ctx->horizon = 1;
+        return 0;
+    }
+
+    /* An entry is usable if it looked at least as far ahead; one that saw
+       the whole remaining game is exact */
+    int remaining = bit_count(empty);
+    int draft = (left < remaining) ? left : remaining;
+
+    int canon = 0;
+    for (int t = 1; t < 8; ++t)
+        if (keys->k[t] < keys->k[canon]) canon = t;
+    uint64_t key = keys->k[canon];
+
+    int tt_move = -1;
+    TTData e;
+    if (!ctx->no_tt && tt_load(key, &e) && e.draft >= draft) {
+        ctx->tt_hits++;
+        if (e.draft < remaining) ctx->horizon = 1;
+        int v = tt_from_node(e.value, depth);
+        if (e.bound == TT_EXACT) return v;
+        if (e.bound == TT_LOWER && v >= beta) return v;
+        if (e.bound == TT_UPPER && v <= alpha) return v;
+        tt_move = sym_perm[sym_inverse[canon]][e.move];
+    }
+
+    /* Facing a threat, any other move loses at once, which is never better
+       than blocking, so only the blocking cells need searching */
+    Bitboard blocks = threat_cells(opp, me);
+    Bitboard cand = blocks ? blocks : empty;
+
+    int order[10], n = 0;
+    if (tt_move >= 0 && (cand & (1u << tt_move))) order[n++] = tt_move;
+    for (int k = 0; k < 9; ++k)
+        if ((cand & (1u << move_order[k])) && move_order[k] != tt_move) order[n++] = move_order[k];
+
+    /* Moves that are images of each other under a symmetry of this
+       position have equal values; search one per class */
+    unsigned stab = stabilizer(me, opp, keys);
+    Bitboard covered = 0;
+
+    int alpha0 = alpha;
+    int best = -INF, bestMove = -1;
+    for (int k = 0; k < n; ++k) {
+        int i = order[k];
+        if (covered & (1u << i)) continue;
+        for (int t = 1; t < 8; ++t)
+            if (stab & (1u << t)) covered |= (Bitboard)(1u << sym_perm[t][i]);
+
+        SymKeys child;
+        keys_play(keys, &child, side, i);
+        int val = -negamax(ctx, opp, (Bitboard)(me | (1u << i)), !side, &child, i,
+                           depth + 1, left - 1, -beta, -alpha);
+        if (ctx->aborted) return 0;
+        if (val > best) {
+            best = val;
+            bestMove = i;
+            if (val > alpha) alpha = val;
+            if (alpha >= beta) {
+                ctx->cutoffs++;
+                break;
             }
         }
-        return best;
-    } else {
-        int best = INT_MAX;
+    }
+
+    int bound = best <= alpha0 ? TT_UPPER : best >= beta ? TT_LOWER : TT_EXACT;
+    if (!ctx->no_tt) tt_store(key, best, bound, sym_perm[canon][bestMove], draft, depth);
+    return best;
+}
+
+/* Searches `left` plies from `board`; returns the move and stores its score */
+static int search_root(SearchCtx *ctx, const char board[9], char ai, char human, int left, int *score) {
+    Bitboard a = board_to_bits(board, ai);
+    Bitboard h = board_to_bits(board, human);
+    Bitboard empty = board_to_bits(board, ' ');
+    int side = (ai == 'X') ? 0 : 1;
+    SymKeys keys;
+    for (int t = 0; t < 8; ++t) {
+        keys.k[t] = (side == 0) ? zobrist_x_to_move : 0;
         for (int i = 0; i < 9; ++i) {
-            if (board[i] == ' ') {
-                board[i] = human;
-                int val = minimax(board, ai, human, depth+1, true);
-                board[i] = ' ';
-                if (val < best) best = val;
-            }
+            if (board[i] == 'X') keys.k[t] ^= zobrist[0][sym_perm[t][i]];
+            else if (board[i] == 'O') keys.k[t] ^= zobrist[1][sym_perm[t][i]];
         }
-        return best;
     }
-}
+    Bitboard wins = threat_cells(a, h);
+    Bitboard blocks = threat_cells(h, a);
 
-int get_best_move(const char board[9], char ai, char human) {
-    int bestVal = INT_MIN;
+    /* Root ordering: winning moves, then blocks, then center-corner-edge */
+    int order[9], n = 0;
+    Bitboard groups[3] = { wins, (Bitboard)(blocks & ~wins), (Bitboard)~(wins | blocks) };
+    for (int g = 0; g < 3; ++g)
+        for (int k = 0; k < 9; ++k)
+            if (empty & groups[g] & (1u << move_order[k])) order[n++] = move_order[k];
+
+    /* A move with a symmetric twin on a lower cell is skipped: the twin has
+       the same value and wins the tie-break below */
+    unsigned stab = stabilizer(a, h, &keys);
+
+    /* Ties go to the lowest cell index, as the plain minimax picked them:
+       a lower-indexed move only has to match the best value, a higher one
+       has to beat it. Values are integers, so bestVal - 1 finds equality. */
+    int bestVal = -INF;
     int bestMove = -1;
-    char copy[9];
-    for (int i = 0; i < 9; ++i) copy[i] = board[i];
-
-    for (int i = 0; i < 9; ++i) {
-        if (copy[i] == ' ') {
-            copy[i] = ai;
-            int moveVal = minimax(copy, ai, human, 0, false);
-            copy[i] = ' ';
-            if (moveVal > bestVal) {
-                bestVal = moveVal;
-                bestMove = i;
-            }
+    for (int k = 0; k < n; ++k) {
+        int i = order[k];
+        bool twin = false;
+        for (int t = 1; t < 8; ++t)
+            if ((stab & (1u << t)) && sym_perm[t][i] < i) twin = true;
+        if (twin) continue;
+
+        int alpha = -INF;
+        if (bestMove >= 0) alpha = (i < bestMove) ? bestVal - 1 : bestVal;
+        SymKeys child;
+        keys_play(&keys, &child, side, i);
+        int moveVal = -negamax(ctx, h, (Bitboard)(a | (1u << i)), !side, &child, i,
+                               0, left - 1, -INF, -alpha);
+        if (ctx->aborted) break;
+        if (moveVal > alpha) {
+            bestVal = moveVal;
+            bestMove = i;
         }
     }
     if (bestMove == -1) {
         /* No moves left; shouldn't be called in that state, but default to 0 */
+        *score = 0;
         return 0;
     }
+    *score = bestVal;
     return bestMove;
 }
+
+#ifdef USE_PERFECT_TABLE
+/* Generated by gen_table (see Makefile): entry = outcome << 4 | move,
+   indexed by the base-3 board code, move 15 for positions not covered */
+extern const unsigned char perfect_table[19683];
+static int table_enabled = 1;
+
+/* Table entry for `board` with `ai` to move, or -1 if it has none */
+static int table_lookup(const char board[9], char ai, char human) {
+    int code = 0, nx = 0, no = 0;
+    for (int i = 8; i >= 0; --i) {
+        int d;
+        if (board[i] == ' ') d = 0;
+        else if (board[i] == 'X') { d = 1; ++nx; }
+        else if (board[i] == 'O') { d = 2; ++no; }
+        else return -1;
+        code = code * 3 + d;
+    }
+    char to_move = (nx == no) ? 'X' : 'O';
+    if (ai != to_move || human != (ai == 'X' ? 'O' : 'X')) return -1;
+    int entry = perfect_table[code];
+    return ((entry & 0x0F) == 0x0F) ? -1 : entry;
+}
+#endif
+
+void ai_set_table_enabled(int enabled) {
+#ifdef USE_PERFECT_TABLE
+    table_enabled = enabled;
+#else
+    (void)enabled;
+#endif
+}
+
+/* Registry entries for get_best_move calls, created once */
+static Metric *m_moves, *m_table_hits, *m_nodes, *m_cutoffs, *m_tt_hits, *m_seconds, *m_depth;
+static pthread_once_t metrics_once = PTHREAD_ONCE_INIT;
+
+static void register_metrics(void) {
+    static const double depth_bounds[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+    m_moves = metrics_counter("ai_moves_total", "get_best_move calls");
+    m_table_hits = metrics_counter("ai_table_hits_total", "Moves answered from the perfect-play table");
+    m_nodes = metrics_counter("ai_nodes_total", "Positions searched");
+    m_cutoffs = metrics_counter("ai_cutoffs_total", "Beta cutoffs");
+    m_tt_hits = metrics_counter("ai_tt_hits_total", "Transposition table hits");
+    m_seconds = metrics_histogram("ai_move_seconds", "Time per get_best_move call", NULL, 0);
+    m_depth = metrics_histogram("ai_search_depth", "Deepest ply reached per search", depth_bounds, 9);
+}
+
+static void record_metrics(const SearchStats *st) {
+    pthread_once(&metrics_once, register_metrics);
+    metrics_add(m_moves, 1);
+    metrics_add(m_table_hits, st->table_hit);
+    metrics_add(m_nodes, (double)st->nodes);
+    metrics_add(m_cutoffs, (double)st->cutoffs);
+    metrics_add(m_tt_hits, (double)st->tt_hits);
+    metrics_observe(m_seconds, st->time_ms / 1000.0);
+    if (!st->table_hit) metrics_observe(m_depth, st->max_depth);
+}
+
+/* Shared by the get_best_move variants; times the call only when
+   statistics are wanted */
+static int best_move(const char board[9], char ai, char human, Outcome *outcome, SearchStats *stats) {
+    int recording = metrics_enabled();
+    SearchStats local;
+    if (!stats && recording) stats = &local;
+    uint64_t start = stats ? timer_now_ns() : 0;
+    SearchCtx ctx = { 0, 0, 0, 0, 0, 0, 0, 0 };
+    int move, score, table_hit = 0;
+
+#ifdef USE_PERFECT_TABLE
+    int entry = table_enabled ? table_lookup(board, ai, human) : -1;
+    if (entry >= 0) {
+        table_hit = 1;
+        move = entry & 0x0F;
+        if (outcome) *outcome = (Outcome)(entry >> 4);
+    } else
+#endif
+    {
+        move = search_root(&ctx, board, ai, human, 9, &score);
+        if (outcome) *outcome = score > 0 ? OUTCOME_WIN : score < 0 ? OUTCOME_LOSS : OUTCOME_DRAW;
+    }
+
+    if (stats) {
+        stats->nodes = ctx.nodes;
+        stats->cutoffs = ctx.cutoffs;
+        stats->tt_hits = ctx.tt_hits;
+        stats->max_depth = ctx.max_depth;
+        stats->table_hit = table_hit;
+        stats->time_ms = timer_elapsed_ms(start);
+        if (recording) record_metrics(stats);
+    }
+    return move;
+}
+
+int get_best_move_outcome(const char board[9], char ai, char human, Outcome *outcome) {
+    return best_move(board, ai, human, outcome, NULL);
+}
+
+int get_best_move_ex(const char board[9], char ai, char human, SearchStats *stats) {
+    return best_move(board, ai, human, NULL, stats);
+}
+
+int get_best_move(const char board[9], char ai, char human) {
+    return best_move(board, ai, human, NULL, NULL);
+}
+
+int get_best_move_depth(const char board[9], char ai, char human, int depth) {
+    /* Entries from deeper searches would let it see past its horizon, so
+       its answer would depend on what ran before */
+    SearchCtx ctx = { 0, 0, 0, 0, 0, 0, 0, 1 };
+    int score;
+    return search_root(&ctx, board, ai, human, depth < 1 ? 1 : depth, &score);
+}
+
+int get_best_move_timed(const char board[9], char ai, char human, int budget_ms, SearchInfo *info) {
+    uint64_t start = timer_now_ns();
+    SearchInfo result = { 0, 0, 0 };
+    int remaining = bit_count(board_to_bits(board, ' '));
+    int best = 0;
+    for (int i = 0; i < 9; ++i) if (board[i] == ' ') { best = i; break; }
+
+#ifdef USE_PERFECT_TABLE
+    int entry = table_enabled ? table_lookup(board, ai, human) : -1;
+    if (entry >= 0) {
+        result.depth = remaining;
+        result.completed = 1;
+        if (info) *info = result;
+        return entry & 0x0F;
+    }
+#endif
+
+    /* The first iteration always runs to completion so there is a move to
+       return; later ones are abandoned when the budget runs out */
+    SearchCtx ctx = { 0, 0, 0, 0, 0, 0, 0, 0 };
+    for (int d = 1; d <= remaining; ++d) {
+        if (d == 2 && budget_ms > 0) ctx.deadline_ns = start + (uint64_t)budget_ms * 1000000ULL;
+        ctx.horizon = 0;
+        int score;
+        int mv = search_root(&ctx, board, ai, human, d, &score);
+        if (ctx.aborted) break;
+        best = mv;
+        result.depth = d;
+        if (!ctx.horizon) {
+            result.completed = 1;
+            break;
+        }
+    }
+    result.nodes = ctx.nodes;
+    if (info) *info = result;
+    return best;
+}
@@ -1,7 +1,60 @@
 #ifndef AI_H
 #define AI_H
 
+#include <stddef.h>
+
 /* Returns index 0-8 for best move for `ai` given current board. `human` is the opponent symbol. */
 int get_best_move(const char board[9], char ai, char human);
 
+/* Result under perfect play for the side to move */
+typedef enum { OUTCOME_LOSS = 0, OUTCOME_DRAW = 1, OUTCOME_WIN = 2 } Outcome;
+
+/* get_best_move that also reports the outcome for `ai` (outcome may be NULL) */
+int get_best_move_outcome(const char board[9], char ai, char human, Outcome *outcome);
+
+/* What one get_best_move call cost */
+typedef struct {
+    unsigned long nodes;    /* positions searched */
+    unsigned long cutoffs;  /* beta cutoffs */
+    unsigned long tt_hits;  /* transposition table probes that found the position */
+    int max_depth;          /* deepest ply reached below the root */
+    int table_hit;          /* non-zero if answered from the perfect-play table */
+    double time_ms;         /* wall time of the call */
+} SearchStats;
+
+/* get_best_move that also fills `stats` (may be NULL) */
+int get_best_move_ex(const char board[9], char ai, char human, SearchStats *stats);
+
+/* Weaker play: looks only `depth` plies ahead (at least 1), scoring anything beyond as
+   a draw. Always searches, even when the perfect-play table is compiled in, and
+   never uses the transposition table, so the move depends only on the position. */
+int get_best_move_depth(const char board[9], char ai, char human, int depth);
+
+/* Builds with USE_PERFECT_TABLE answer reachable positions from a table
+   compiled into the binary; pass 0 to force the search instead. */
+void ai_set_table_enabled(int enabled);
+
+/* What a timed search achieved */
+typedef struct {
+    int depth;              /* plies of the deepest completed iteration */
+    unsigned long nodes;    /* nodes visited over all iterations */
+    int completed;          /* non-zero if that iteration saw every line to the end */
+} SearchInfo;
+
+/* Iterative deepening: searches 1, 2, ... plies until `budget_ms` runs out (<= 0 for no
+   limit) and returns the best move of the deepest completed iteration. `info` may be NULL. */
+int get_best_move_timed(const char board[9], char ai, char human, int budget_ms, SearchInfo *info);
+
+/* Transposition table replacement policy: overwrite on every store, or keep the deeper entry */
+typedef enum { TT_REPLACE_ALWAYS, TT_REPLACE_DEPTH } TTReplace;
+
+/* Limit the transposition table to `bytes` (0 = built-in table) with the given policy.
+   The table persists across get_best_move calls and is shared by calls on different
+   threads; configure and clear it only while no search is running.
+   Returns 0 on success, -1 on allocation failure. */
+int ai_tt_configure(size_t bytes, TTReplace policy);
+
+/* Forget all cached positions */
+void ai_tt_clear(void);
+
 #endif /* AI_H */
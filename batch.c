@@ -0,0 +1,194 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#include <unistd.h>
+#else
+#include <windows.h>
+#endif
+#include "batch.h"
+#include "ai.h"
+#include "game.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Input is read in large chunks cut at the last newline. Each chunk is
+   split into one slice of whole lines per thread; every thread parses,
+   solves and formats its slice into its own buffer, and the buffers are
+   written in slice order, so the output keeps the input order. */
+
+#define CHUNK_BYTES (4u << 20)
+#define MIN_SLICE_BYTES (64u << 10)   /* smaller chunks are not worth a thread */
+#define MAX_THREADS 64
+#define MAX_LINE_OUT 24               /* 9 cells, move, value and separators */
+
+typedef struct {
+    const char *begin, *end;    /* whole lines */
+    char *out;
+    size_t out_len, out_cap;
+    long count;
+    int failed;                 /* out of memory */
+} Slice;
+
+static int cpu_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return (int)si.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+static const char *const value_names[] = { "loss", "draw", "win" };
+
+/* Formats the answer for one line (without its newline) into `dst` and
+   returns its length, or 0 for a blank line */
+static size_t solve_line(const char *line, size_t len, char *dst) {
+    if (len > 0 && line[len - 1] == '\r') --len;
+    if (len == 0) return 0;
+
+    char board[9];
+    int nx = 0, no = 0, ok = (len == 9);
+    for (size_t i = 0; ok && i < 9; ++i) {
+        if (line[i] == 'X') { board[i] = 'X'; ++nx; }
+        else if (line[i] == 'O') { board[i] = 'O'; ++no; }
+        else if (line[i] == '-') board[i] = ' ';
+        else ok = 0;
+    }
+    if (ok && nx != no && nx != no + 1) ok = 0;
+
+    /* Malformed lines are echoed cut to 9 characters to keep the columns */
+    size_t n = len < 9 ? len : 9;
+    memcpy(dst, line, n);
+    if (!ok) {
+        memcpy(dst + n, " - invalid\n", 11);
+        return n + 11;
+    }
+    if (check_winner(board) != ' ') {
+        memcpy(dst + n, " - over\n", 8);
+        return n + 8;
+    }
+
+    char to_move = (nx == no) ? 'X' : 'O';
+    Outcome outcome;
+    int mv = get_best_move_outcome(board, to_move, to_move == 'X' ? 'O' : 'X', &outcome);
+    const char *value = value_names[outcome];
+    size_t vlen = strlen(value);
+    dst[n] = ' ';
+    dst[n + 1] = (char)('0' + mv);
+    dst[n + 2] = ' ';
+    memcpy(dst + n + 3, value, vlen);
+    dst[n + 3 + vlen] = '\n';
+    return n + 4 + vlen;
+}
+
+static void *solve_slice(void *arg) {
+    Slice *s = arg;
+    s->out_len = 0;
+    s->count = 0;
+    s->failed = 0;
+    for (const char *p = s->begin; p < s->end;) {
+        const char *nl = memchr(p, '\n', (size_t)(s->end - p));
+        const char *line_end = nl ? nl : s->end;
+        if (s->out_cap - s->out_len < MAX_LINE_OUT) {
+            size_t cap = s->out_cap ? s->out_cap * 2 : (size_t)(s->end - s->begin) * 2 + MAX_LINE_OUT;
+            char *grown = realloc(s->out, cap);
+            if (!grown) {
+                s->failed = 1;
+                return NULL;
+            }
+            s->out = grown;
+            s->out_cap = cap;
+        }
+        size_t n = solve_line(p, (size_t)(line_end - p), s->out + s->out_len);
+        if (n) {
+            s->out_len += n;
+            s->count++;
+        }
+        p = line_end + 1;
+    }
+    return NULL;
+}
+
+/* Solves the whole lines in buf[0, len) and writes the answers in order */
+static long process_chunk(const char *buf, size_t len, Slice *slices, int threads, FILE *out) {
+    int n = 1;
+    while (n < threads && len / (size_t)(n + 1) >= MIN_SLICE_BYTES) ++n;
+
+    /* Cut at the first newline after each even split point */
+    const char *p = buf, *end = buf + len;
+    for (int i = 0; i < n; ++i) {
+        const char *cut = (i == n - 1) ? end : buf + len / (size_t)n * (size_t)(i + 1);
+        if (cut < p) cut = p;
+        if (cut < end) {
+            const char *nl = memchr(cut, '\n', (size_t)(end - cut));
+            cut = nl ? nl + 1 : end;
+        }
+        slices[i].begin = p;
+        slices[i].end = cut;
+        p = cut;
+    }
+
+    pthread_t tids[MAX_THREADS];
+    int started[MAX_THREADS] = { 0 };
+    for (int i = 1; i < n; ++i)
+        started[i] = (pthread_create(&tids[i], NULL, solve_slice, &slices[i]) == 0);
+    solve_slice(&slices[0]);
+    for (int i = 1; i < n; ++i) {
+        if (started[i]) pthread_join(tids[i], NULL);
+        else solve_slice(&slices[i]);
+    }
+
+    long count = 0;
+    for (int i = 0; i < n; ++i) {
+        if (slices[i].failed) return -1;
+        if (fwrite(slices[i].out, 1, slices[i].out_len, out) != slices[i].out_len) return -1;
+        count += slices[i].count;
+    }
+    return count;
+}
+
+long batch_run(FILE *in, FILE *out, int threads) {
+    if (threads <= 0) threads = cpu_count();
+    if (threads > MAX_THREADS) threads = MAX_THREADS;
+
+    char *buf = malloc(CHUNK_BYTES);
+    Slice slices[MAX_THREADS];
+    memset(slices, 0, sizeof(slices));
+    if (!buf) return -1;
+
+    long total = 0;
+    size_t carry = 0;
+    for (;;) {
+        size_t got = fread(buf + carry, 1, CHUNK_BYTES - carry, in);
+        size_t len = carry + got;
+        if (len == 0) break;
+        int eof = (got == 0);
+
+        /* Only whole lines now; the tail waits for the next read. A line
+           filling the whole buffer is cut and reported as invalid. */
+        size_t whole = len;
+        if (!eof) {
+            const char *last = NULL;
+            for (size_t i = len; i > 0; --i)
+                if (buf[i - 1] == '\n') { last = buf + i; break; }
+            if (last) whole = (size_t)(last - buf);
+        }
+
+        long n = process_chunk(buf, whole, slices, threads, out);
+        if (n < 0) {
+            total = -1;
+            break;
+        }
+        total += n;
+        carry = len - whole;
+        memmove(buf, buf + whole, carry);
+        if (eof) break;
+    }
+    if (total >= 0 && ferror(in)) total = -1;
+
+    for (int i = 0; i < MAX_THREADS; ++i) free(slices[i].out);
+    free(buf);
+    return total;
+}
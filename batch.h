@@ -0,0 +1,15 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdio.h>
+
+/* Analyzes positions read from `in`, one per line as 9 characters of X, O and -
+   (cells 0-8, the format of the OpenAI prompt). For each line, in input order,
+   writes "<position> <move> <value>" to `out`: the best move 0-8 for the side to
+   move and its value under perfect play (win, draw or loss). Finished games get
+   "- over" and malformed lines "- invalid"; blank lines are skipped.
+   Work is split across `threads` threads (<= 0 for one per CPU).
+   Returns the number of positions written, or -1 on a read or write error. */
+long batch_run(FILE *in, FILE *out, int threads);
+
+#endif /* BATCH_H */
@@ -0,0 +1,195 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "game.h"
+#include "ai.h"
+#include "timer.h"
+
+/* Engine benchmark: runs a fixed suite of positions through get_best_move
+   and check_winner and reports per-call latency (min / median / p99),
+   nodes and nodes/sec.
+
+   Usage: bench_engine [--json FILE] [--baseline FILE] [--tolerance PCT]
+
+   --json writes the results as JSON; --baseline compares each case's
+   median against a previous --json file and exits 1 if any is more than
+   --tolerance percent (default 25) slower. */
+
+typedef enum { CASE_WINNER, CASE_MOVE, CASE_SEARCH } CaseKind;
+
+typedef struct {
+    const char *name;
+    CaseKind kind;
+    const char *board;      /* 9 chars, X/O/- */
+    char ai;
+} BenchCase;
+
+static const BenchCase cases[] = {
+    { "winner_empty",       CASE_WINNER, "---------", 'X' },
+    { "winner_midgame",     CASE_WINNER, "X-O-X-O--", 'X' },
+    { "winner_won",         CASE_WINNER, "XXXOO----", 'X' },
+    { "winner_full",        CASE_WINNER, "XOXXOOOXX", 'X' },
+    { "move_empty",         CASE_MOVE,   "---------", 'X' },
+    { "move_opening",       CASE_MOVE,   "----X----", 'O' },
+    { "move_midgame",       CASE_MOVE,   "X-O-X----", 'O' },
+    { "move_near_terminal", CASE_MOVE,   "XOXOXO---", 'X' },
+    { "search_empty",       CASE_SEARCH, "---------", 'X' },
+    { "search_opening",     CASE_SEARCH, "----X----", 'O' },
+    { "search_midgame",     CASE_SEARCH, "X-O-X----", 'O' },
+    { "search_near_terminal", CASE_SEARCH, "XOXOXO---", 'X' },
+};
+#define NUM_CASES (int)(sizeof(cases) / sizeof(cases[0]))
+
+/* Samples per case; fast cases time BATCH calls per sample */
+#define SAMPLES 2000
+#define BATCH 64
+
+typedef struct {
+    double min_ns, median_ns, p99_ns;
+    double wall_ms;
+    unsigned long long calls;
+    unsigned long long nodes;
+} BenchResult;
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static volatile int sink;
+
+static void run_case(const BenchCase *c, BenchResult *r) {
+    static double samples[SAMPLES];
+    char board[9];
+    for (int i = 0; i < 9; ++i) board[i] = (c->board[i] == '-') ? ' ' : c->board[i];
+    char human = (c->ai == 'X') ? 'O' : 'X';
+    int batch = (c->kind == CASE_SEARCH) ? 1 : BATCH;
+
+    memset(r, 0, sizeof(*r));
+    ai_set_table_enabled(c->kind != CASE_SEARCH);
+    uint64_t start = timer_now_ns();
+    for (int s = 0; s < SAMPLES; ++s) {
+        /* searches start cold so every sample does the same work */
+        if (c->kind == CASE_SEARCH) ai_tt_clear();
+        uint64_t t0 = timer_now_ns();
+        for (int b = 0; b < batch; ++b) {
+            if (c->kind == CASE_WINNER) {
+                sink += check_winner(board);
+            } else if (c->kind == CASE_MOVE) {
+                sink += get_best_move(board, c->ai, human);
+            } else {
+                SearchStats stats;
+                sink += get_best_move_ex(board, c->ai, human, &stats);
+                r->nodes += stats.nodes;
+            }
+        }
+        samples[s] = (double)(timer_now_ns() - t0) / batch;
+    }
+    r->wall_ms = timer_elapsed_ms(start);
+    r->calls = (unsigned long long)SAMPLES * batch;
+    ai_set_table_enabled(1);
+
+    qsort(samples, SAMPLES, sizeof(double), cmp_double);
+    r->min_ns = samples[0];
+    r->median_ns = samples[SAMPLES / 2];
+    r->p99_ns = samples[(SAMPLES * 99) / 100];
+}
+
+static void write_json(FILE *f, const BenchResult *res) {
+    fprintf(f, "{\n  \"cases\": [\n");
+    for (int i = 0; i < NUM_CASES; ++i) {
+        const BenchResult *r = &res[i];
+        double nps = r->wall_ms > 0 ? r->nodes / (r->wall_ms / 1000.0) : 0;
+        fprintf(f, "    {\"name\": \"%s\", \"calls\": %llu, \"wall_ms\": %.3f, "
+                   "\"min_ns\": %.1f, \"median_ns\": %.1f, \"p99_ns\": %.1f, "
+                   "\"nodes\": %llu, \"nodes_per_sec\": %.0f}%s\n",
+                cases[i].name, r->calls, r->wall_ms, r->min_ns, r->median_ns, r->p99_ns,
+                r->nodes, nps, i < NUM_CASES - 1 ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+}
+
+/* Median of case `name` in a file written by write_json, or -1 */
+static double baseline_median(const char *json, const char *name) {
+    char key[128];
+    snprintf(key, sizeof(key), "\"name\": \"%s\"", name);
+    const char *p = strstr(json, key);
+    if (!p) return -1;
+    p = strstr(p, "\"median_ns\":");
+    if (!p) return -1;
+    return atof(p + strlen("\"median_ns\":"));
+}
+
+static char *read_file(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *buf = malloc((size_t)len + 1);
+    if (buf) {
+        size_t got = fread(buf, 1, (size_t)len, f);
+        buf[got] = '\0';
+    }
+    fclose(f);
+    return buf;
+}
+
+int main(int argc, char **argv) {
+    const char *json_path = NULL, *baseline_path = NULL;
+    double tolerance = 25.0;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--json") && i + 1 < argc) json_path = argv[++i];
+        else if (!strcmp(argv[i], "--baseline") && i + 1 < argc) baseline_path = argv[++i];
+        else if (!strcmp(argv[i], "--tolerance") && i + 1 < argc) tolerance = atof(argv[++i]);
+        else {
+            fprintf(stderr, "Usage: %s [--json FILE] [--baseline FILE] [--tolerance PCT]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    BenchResult res[NUM_CASES];
+    printf("%-22s %10s %10s %10s %10s %12s %14s\n",
+           "case", "calls", "min ns", "median ns", "p99 ns", "nodes", "nodes/sec");
+    for (int i = 0; i < NUM_CASES; ++i) {
+        run_case(&cases[i], &res[i]);
+        double nps = res[i].wall_ms > 0 ? res[i].nodes / (res[i].wall_ms / 1000.0) : 0;
+        printf("%-22s %10llu %10.1f %10.1f %10.1f %12llu %14.0f\n", cases[i].name, res[i].calls,
+               res[i].min_ns, res[i].median_ns, res[i].p99_ns, res[i].nodes, nps);
+    }
+
+    if (json_path) {
+        FILE *f = fopen(json_path, "w");
+        if (!f) {
+            fprintf(stderr, "Cannot write %s\n", json_path);
+            return 2;
+        }
+        write_json(f, res);
+        fclose(f);
+    }
+
+    int failed = 0;
+    if (baseline_path) {
+        char *base = read_file(baseline_path);
+        if (!base) {
+            fprintf(stderr, "Cannot read baseline %s\n", baseline_path);
+            return 2;
+        }
+        printf("\nAgainst %s (tolerance %.0f%%):\n", baseline_path, tolerance);
+        for (int i = 0; i < NUM_CASES; ++i) {
+            double old = baseline_median(base, cases[i].name);
+            if (old <= 0) {
+                printf("  %-22s no baseline\n", cases[i].name);
+                continue;
+            }
+            double change = (res[i].median_ns - old) / old * 100.0;
+            int slow = change > tolerance;
+            printf("  %-22s %10.1f -> %10.1f ns (%+.1f%%)%s\n", cases[i].name, old,
+                   res[i].median_ns, change, slow ? "  SLOWER" : "");
+            failed |= slow;
+        }
+        free(base);
+        if (failed) printf("\nFAIL: benchmark regressed beyond %.0f%%\n", tolerance);
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,203 @@
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include "game.h"
+#include "ai.h"
+#include "mnk_ai.h"
+
+/* Correctness checks for the engines (`make check`); exits 1 if any fails.
+
+     depth_search
+               get_best_move_depth gives the same move at every depth from
+               an empty transposition table and from one filled by full
+               searches, so the depth:N tournament source does not depend
+               on what was searched before
+     mnk_3x3   mnk_get_best_move on a 3,3,3 board picks a move of the same
+               value (win, draw or loss) as get_best_move in every reachable
+               position; where several moves are equally good the two may
+               pick different ones
+     mnk_threads
+               mnk_get_best_move_depth with MNK_CHECK_THREADS threads picks
+               the serial search's move on random 7,7,4 positions
+     mnk_concurrent
+               the same searches, run while another thread keeps hitting
+               the deadline of timed searches, still pick those moves
+
+   Each check prints one line with the positions tried and the failures. */
+
+/* Every reachable, unfinished position and the side to move */
+#define BOARD_CODES 19683
+static char reachable[BOARD_CODES][9];
+static char reachable_turn[BOARD_CODES];
+static int reachable_count;
+
+static void collect_positions(char board[9], char turn, unsigned char *seen) {
+    int code = 0;
+    for (int i = 8; i >= 0; --i) code = code * 3 + (board[i] == 'X' ? 1 : board[i] == 'O' ? 2 : 0);
+    if (seen[code] || check_winner(board) != ' ') return;
+    seen[code] = 1;
+    memcpy(reachable[reachable_count], board, 9);
+    reachable_turn[reachable_count++] = turn;
+    for (int i = 0; i < 9; ++i) {
+        if (board[i] != ' ') continue;
+        board[i] = turn;
+        collect_positions(board, turn == 'X' ? 'O' : 'X', seen);
+        board[i] = ' ';
+    }
+}
+
+static int report(const char *name, int tried, int failures) {
+    printf("%-15s %6d positions  %d failed%s\n", name, tried, failures, failures ? "  FAIL" : "");
+    return failures != 0;
+}
+
+/* Searches each position at each depth from an empty transposition table,
+   then again after full searches have filled it */
+static int check_depth_search(void) {
+    static signed char cold[BOARD_CODES][9];
+    for (int p = 0; p < reachable_count; ++p) {
+        char me = reachable_turn[p], other = (me == 'X') ? 'O' : 'X';
+        for (int d = 1; d <= 9; ++d) {
+            ai_tt_clear();
+            cold[p][d - 1] = (signed char)get_best_move_depth(reachable[p], me, other, d);
+        }
+    }
+
+    ai_set_table_enabled(0);
+    for (int p = 0; p < reachable_count; ++p) {
+        char me = reachable_turn[p], other = (me == 'X') ? 'O' : 'X';
+        get_best_move(reachable[p], me, other);
+    }
+    ai_set_table_enabled(1);
+
+    int failures = 0;
+    for (int p = 0; p < reachable_count; ++p) {
+        char me = reachable_turn[p], other = (me == 'X') ? 'O' : 'X';
+        for (int d = 1; d <= 9; ++d)
+            if (get_best_move_depth(reachable[p], me, other, d) != cold[p][d - 1]) failures++;
+    }
+    ai_tt_clear();
+    return report("depth_search", reachable_count * 9, failures);
+}
+
+/* Random positions for the m,n,k checks */
+#define MNK_POSITIONS 60
+#define MNK_CHECK_DEPTH 4
+#define MNK_CHECK_THREADS 4
+
+static MnkBoard mnk_positions[MNK_POSITIONS];
+static int mnk_serial[MNK_POSITIONS];
+
+static unsigned xorshift(unsigned *state) {
+    unsigned x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+/* 4-12 random stones on a 7,7,4 board with nobody having won */
+static void random_mnk_position(MnkBoard *b, unsigned *rng) {
+    for (;;) {
+        mnk_init(b, 7, 7, 4);
+        int stones = 4 + (int)(xorshift(rng) % 9);
+        for (int i = 0; i < stones; ++i) {
+            int cell;
+            do cell = (int)(xorshift(rng) % (unsigned)b->size); while (mnk_at(b, cell) != MNK_EMPTY);
+            mnk_place(b, cell, (i % 2 == 0) ? 'X' : 'O');
+        }
+        if (mnk_check_winner(b) == ' ') return;
+    }
+}
+
+static char mnk_to_move(const MnkBoard *b) {
+    return (b->stones % 2 == 0) ? 'X' : 'O';
+}
+
+static int mnk_mismatches(void) {
+    int failures = 0;
+    for (int p = 0; p < MNK_POSITIONS; ++p) {
+        char me = mnk_to_move(&mnk_positions[p]), other = (me == 'X') ? 'O' : 'X';
+        if (mnk_get_best_move_depth(&mnk_positions[p], me, other, MNK_CHECK_DEPTH) != mnk_serial[p]) failures++;
+    }
+    return failures;
+}
+
+/* Outcome for `me` of playing `mv`, with perfect play after it */
+static Outcome outcome_after(const char board[9], int mv, char me, char other) {
+    char next[9];
+    memcpy(next, board, 9);
+    next[mv] = me;
+    char w = check_winner(next);
+    if (w == me) return OUTCOME_WIN;
+    if (w == 'T') return OUTCOME_DRAW;
+    Outcome reply;
+    get_best_move_outcome(next, other, me, &reply);
+    return (Outcome)(OUTCOME_WIN - reply);
+}
+
+static int check_mnk_3x3(void) {
+    int failures = 0;
+    for (int p = 0; p < reachable_count; ++p) {
+        const char *board = reachable[p];
+        char me = reachable_turn[p], other = (me == 'X') ? 'O' : 'X';
+        MnkBoard b;
+        mnk_from_board(&b, board);
+        int mv = mnk_get_best_move(&b, me, other);
+        if (mv < 0 || mv > 8 || board[mv] != ' ' ||
+            outcome_after(board, mv, me, other) != outcome_after(board, get_best_move(board, me, other), me, other))
+            failures++;
+    }
+    return report("mnk_3x3", reachable_count, failures);
+}
+
+static int check_mnk_threads(void) {
+    unsigned rng = 12345u;
+    mnk_ai_set_threads(1);
+    for (int p = 0; p < MNK_POSITIONS; ++p) {
+        random_mnk_position(&mnk_positions[p], &rng);
+        char me = mnk_to_move(&mnk_positions[p]), other = (me == 'X') ? 'O' : 'X';
+        mnk_serial[p] = mnk_get_best_move_depth(&mnk_positions[p], me, other, MNK_CHECK_DEPTH);
+    }
+    mnk_ai_set_threads(MNK_CHECK_THREADS);
+    return report("mnk_threads", MNK_POSITIONS, mnk_mismatches());
+}
+
+static int interfering;
+
+/* Timed searches on a big board, each stopped by its 1 ms budget */
+static void *interfere(void *arg) {
+    (void)arg;
+    MnkBoard b;
+    mnk_init(&b, 15, 15, 5);
+    mnk_place(&b, 112, 'X');
+    while (__atomic_load_n(&interfering, __ATOMIC_RELAXED))
+        mnk_get_best_move_timed(&b, 'O', 'X', 1, NULL);
+    return NULL;
+}
+
+static int check_mnk_concurrent(void) {
+    pthread_t thread;
+    __atomic_store_n(&interfering, 1, __ATOMIC_RELAXED);
+    if (pthread_create(&thread, NULL, interfere, NULL) != 0) return report("mnk_concurrent", 0, 1);
+    int failures = mnk_mismatches();
+    __atomic_store_n(&interfering, 0, __ATOMIC_RELAXED);
+    pthread_join(thread, NULL);
+    mnk_ai_set_threads(1);
+    return report("mnk_concurrent", MNK_POSITIONS, failures);
+}
+
+int main(void) {
+    static unsigned char seen[BOARD_CODES];
+    char board[9];
+    init_board(board);
+    collect_positions(board, 'X', seen);
+
+    int failed = 0;
+    failed |= check_depth_search();
+    failed |= check_mnk_3x3();
+    failed |= check_mnk_threads();
+    failed |= check_mnk_concurrent();
+    if (failed) printf("FAIL\n");
+    return failed;
+}
@@ -1,12 +1,37 @@
 #include "game.h"
 #include <stdio.h>
 
-static int win_lines[8][3] = {
-    {0,1,2},{3,4,5},{6,7,8},
-    {0,3,6},{1,4,7},{2,5,8},
-    {0,4,8},{2,4,6}
+const Bitboard win_masks[8] = {
+    0x007, 0x038, 0x1C0,   /* rows */
+    0x049, 0x092, 0x124,   /* columns */
+    0x111, 0x054           /* diagonals */
 };
 
+const Bitboard cell_lines[9][5] = {
+    {0x007, 0x049, 0x111, 0},
+    {0x007, 0x092, 0},
+    {0x007, 0x124, 0x054, 0},
+    {0x038, 0x049, 0},
+    {0x038, 0x092, 0x111, 0x054, 0},
+    {0x038, 0x124, 0},
+    {0x1C0, 0x049, 0x054, 0},
+    {0x1C0, 0x092, 0},
+    {0x1C0, 0x124, 0x111, 0}
+};
+
+const int sym_perm[8][9] = {
+    { 0, 1, 2, 3, 4, 5, 6, 7, 8 },
+    { 2, 5, 8, 1, 4, 7, 0, 3, 6 },
+    { 8, 7, 6, 5, 4, 3, 2, 1, 0 },
+    { 6, 3, 0, 7, 4, 1, 8, 5, 2 },
+    { 2, 1, 0, 5, 4, 3, 8, 7, 6 },
+    { 6, 7, 8, 3, 4, 5, 0, 1, 2 },
+    { 0, 3, 6, 1, 4, 7, 2, 5, 8 },
+    { 8, 5, 2, 7, 4, 1, 6, 3, 0 }
+};
+
+const int sym_inverse[8] = { 0, 3, 2, 1, 4, 5, 6, 7 };
+
 void init_board(char board[9]) {
     for (int i = 0; i < 9; ++i) board[i] = ' ';
 }
@@ -22,11 +47,40 @@ void print_board(const char b[9]) {
     printf("\n\n");
 }
 
-char check_winner(const char b[9]) {
+Bitboard board_to_bits(const char board[9], char sym) {
+    Bitboard m = 0;
+    for (int i = 0; i < 9; ++i)
+        if (board[i] == sym) m |= (Bitboard)(1u << i);
+    return m;
+}
+
+Bitboard bits_transform(Bitboard m, int t) {
+    Bitboard r = 0;
+    for (int i = 0; i < 9; ++i)
+        if (m & (1u << i)) r |= (Bitboard)(1u << sym_perm[t][i]);
+    return r;
+}
+
+int bits_canonical(Bitboard *x, Bitboard *o) {
+    unsigned best = ((unsigned)*x << 9) | *o;
+    int bestT = 0;
+    for (int t = 1; t < 8; ++t) {
+        unsigned c = ((unsigned)bits_transform(*x, t) << 9) | bits_transform(*o, t);
+        if (c < best) { best = c; bestT = t; }
+    }
+    *x = (Bitboard)(best >> 9);
+    *o = (Bitboard)(best & BOARD_FULL);
+    return bestT;
+}
+
+char bits_winner(Bitboard x, Bitboard o) {
     for (int i = 0; i < 8; ++i) {
-        int a = win_lines[i][0], c = win_lines[i][1], d = win_lines[i][2];
-        if (b[a] != ' ' && b[a] == b[c] && b[c] == b[d]) return b[a];
+        if ((x & win_masks[i]) == win_masks[i]) return 'X';
+        if ((o & win_masks[i]) == win_masks[i]) return 'O';
     }
-    for (int i = 0; i < 9; ++i) if (b[i] == ' ') return ' ';
-    return 'T';
+    return ((x | o) == BOARD_FULL) ? 'T' : ' ';
+}
+
+char check_winner(const char b[9]) {
+    return bits_winner(board_to_bits(b, 'X'), board_to_bits(b, 'O'));
 }
@@ -1,6 +1,23 @@
 #ifndef GAME_H
 #define GAME_H
 
+/* Bitboard: one 9-bit mask per side, bit i set when cell i is taken */
+typedef unsigned short Bitboard;
+
+#define BOARD_FULL 0x1FF
+
+/* The 8 winning lines as masks (rows, columns, diagonals) */
+extern const Bitboard win_masks[8];
+
+/* Lines through each cell, terminated by 0 */
+extern const Bitboard cell_lines[9][5];
+
+/* The 8 board symmetries (identity, rotations by 90/180/270, then mirror
+   left-right, mirror top-bottom, main and anti diagonal): transform t moves
+   cell i to sym_perm[t][i]. sym_inverse[t] undoes t. */
+extern const int sym_perm[8][9];
+extern const int sym_inverse[8];
+
 /* Initialize board to empty spaces */
 void init_board(char board[9]);
 
@@ -10,4 +27,31 @@ void print_board(const char board[9]);
 /* Check for winner: returns 'X' or 'O' when someone wins, 'T' for tie, ' ' for game ongoing */
 char check_winner(const char board[9]);
 
+/* Mask of the cells of `board` holding `sym` */
+Bitboard board_to_bits(const char board[9], char sym);
+
+/* Apply symmetry `t` to mask `m` */
+Bitboard bits_transform(Bitboard m, int t);
+
+/* Replace (x, o) by its canonical orientation, the one with the smallest
+   (x << 9 | o) over the 8 symmetries. Returns the transform applied. */
+int bits_canonical(Bitboard *x, Bitboard *o);
+
+/* check_winner for masks */
+char bits_winner(Bitboard x, Bitboard o);
+
+/* Non-zero when `m` contains a complete line */
+static inline int bits_has_line(Bitboard m) {
+    for (int i = 0; i < 8; ++i)
+        if ((m & win_masks[i]) == win_masks[i]) return 1;
+    return 0;
+}
+
+/* Non-zero when `m` has a complete line through cell `sq` (the last stone placed) */
+static inline int bits_line_through(Bitboard m, int sq) {
+    for (const Bitboard *l = cell_lines[sq]; *l; ++l)
+        if ((m & *l) == *l) return 1;
+    return 0;
+}
+
 #endif /* GAME_H */
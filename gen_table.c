@@ -0,0 +1,54 @@
+#include <stdio.h>
+#include "game.h"
+#include "ai.h"
+
+/* Solves every position reachable from the empty board (X moves first)
+   with the search engine and prints perfect_table.c: one byte per base-3
+   board code, outcome << 4 | best move, 0x0F where there is no entry. */
+
+static unsigned char table[19683];
+
+static int board_code(const char b[9]) {
+    int code = 0;
+    for (int i = 8; i >= 0; --i)
+        code = code * 3 + (b[i] == 'X' ? 1 : b[i] == 'O' ? 2 : 0);
+    return code;
+}
+
+static void solve(char board[9], char to_move) {
+    int code = board_code(board);
+    if (table[code] != 0x0F || check_winner(board) != ' ') return;
+
+    char other = (to_move == 'X') ? 'O' : 'X';
+    Outcome outcome;
+    int mv = get_best_move_outcome(board, to_move, other, &outcome);
+    table[code] = (unsigned char)((outcome << 4) | mv);
+
+    for (int i = 0; i < 9; ++i) {
+        if (board[i] != ' ') continue;
+        board[i] = to_move;
+        solve(board, other);
+        board[i] = ' ';
+    }
+}
+
+int main(void) {
+    for (int i = 0; i < 19683; ++i) table[i] = 0x0F;
+
+    char board[9];
+    init_board(board);
+    solve(board, 'X');
+
+    int count = 0;
+    for (int i = 0; i < 19683; ++i) if (table[i] != 0x0F) ++count;
+
+    printf("/* Generated by gen_table; do not edit. */\n");
+    printf("/* %d positions: outcome << 4 | best move, 0x0F = no entry */\n\n", count);
+    printf("const unsigned char perfect_table[19683] = {");
+    for (int i = 0; i < 19683; ++i) {
+        if (i % 16 == 0) printf("\n   ");
+        printf(" 0x%02X%s", table[i], i < 19682 ? "," : "");
+    }
+    printf("\n};\n");
+    return 0;
+}
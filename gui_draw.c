@@ -0,0 +1,288 @@
+#include "gui_draw.h"
+#include <math.h>
+#include <stdlib.h>
+
+#if !SDL_VERSION_ATLEAST(2, 0, 18)
+#error "gui_draw.c needs SDL 2.0.18 or newer (SDL_RenderGeometry)"
+#endif
+
+/* Every shape becomes untextured triangles with per-vertex colors, so one
+   draw call covers any mix of them. Soft edges are vertex rows whose alpha
+   drops to zero, left to the interpolation between them.
+
+   Cached shapes are painted with alpha blending into a transparent target
+   texture, which leaves premultiplied colors, and are copied out with a
+   matching blend mode. Without render targets they are painted directly
+   through a transform instead. */
+
+#define CACHE_SLOTS 16
+#define PI 3.14159265f
+
+typedef struct {
+    int key;
+    SDL_Texture *tex;       /* NULL if the slot is free */
+} CachedShape;
+
+struct GuiDraw {
+    SDL_Renderer *ren;
+    SDL_Vertex *vertices;
+    int *indices;
+    int vertex_count, vertex_cap;
+    int index_count, index_cap;
+
+    /* applied to every vertex: position * scale + origin, alpha * fade */
+    float origin_x, origin_y, scale_x, scale_y, fade;
+
+    CachedShape cache[CACHE_SLOTS];
+    int next_evict;
+    int no_targets;         /* the renderer cannot draw into textures */
+    unsigned long draw_calls;
+};
+
+GuiDraw *gui_draw_create(SDL_Renderer *ren) {
+    GuiDraw *d = calloc(1, sizeof(GuiDraw));
+    if (!d) return NULL;
+    d->ren = ren;
+    d->scale_x = d->scale_y = d->fade = 1.0f;
+    return d;
+}
+
+/* Makes room for `vertices` and `indices` more; returns 0 on success */
+static int reserve(GuiDraw *d, int vertices, int indices) {
+    if (d->vertex_count + vertices > d->vertex_cap) {
+        int cap = d->vertex_cap ? d->vertex_cap : 1024;
+        while (cap < d->vertex_count + vertices) cap *= 2;
+        SDL_Vertex *v = realloc(d->vertices, (size_t)cap * sizeof(SDL_Vertex));
+        if (!v) return -1;
+        d->vertices = v;
+        d->vertex_cap = cap;
+    }
+    if (d->index_count + indices > d->index_cap) {
+        int cap = d->index_cap ? d->index_cap : 2048;
+        while (cap < d->index_count + indices) cap *= 2;
+        int *i = realloc(d->indices, (size_t)cap * sizeof(int));
+        if (!i) return -1;
+        d->indices = i;
+        d->index_cap = cap;
+    }
+    return 0;
+}
+
+/* Appends a vertex (room must be reserved) and returns its index */
+static int vertex(GuiDraw *d, float x, float y, SDL_Color c, float alpha) {
+    SDL_Vertex *v = &d->vertices[d->vertex_count];
+    v->position.x = x * d->scale_x + d->origin_x;
+    v->position.y = y * d->scale_y + d->origin_y;
+    v->color = c;
+    v->color.a = (Uint8)(c.a * alpha * d->fade + 0.5f);
+    v->tex_coord.x = v->tex_coord.y = 0.0f;
+    return d->vertex_count++;
+}
+
+static void triangle(GuiDraw *d, int a, int b, int c) {
+    d->indices[d->index_count++] = a;
+    d->indices[d->index_count++] = b;
+    d->indices[d->index_count++] = c;
+}
+
+static void quad(GuiDraw *d, int a, int b, int c, int e) {
+    triangle(d, a, b, c);
+    triangle(d, a, c, e);
+}
+
+void gui_draw_gradient_rect(GuiDraw *d, SDL_Rect r, SDL_Color top, SDL_Color bottom) {
+    if (reserve(d, 4, 6) != 0) return;
+    float x0 = (float)r.x, y0 = (float)r.y, x1 = x0 + r.w, y1 = y0 + r.h;
+    int a = vertex(d, x0, y0, top, 1.0f);
+    int b = vertex(d, x1, y0, top, 1.0f);
+    int c = vertex(d, x1, y1, bottom, 1.0f);
+    int e = vertex(d, x0, y1, bottom, 1.0f);
+    quad(d, a, b, c, e);
+}
+
+void gui_draw_rect(GuiDraw *d, SDL_Rect r, SDL_Color color) {
+    gui_draw_gradient_rect(d, r, color, color);
+}
+
+void gui_draw_rounded_rect(GuiDraw *d, SDL_Rect r, int radius, SDL_Color color) {
+    if (radius > r.w / 2) radius = r.w / 2;
+    if (radius > r.h / 2) radius = r.h / 2;
+    if (radius <= 0) {
+        gui_draw_rect(d, r, color);
+        return;
+    }
+
+    /* A fan from the center over the outline: each corner an arc */
+    int steps = radius / 2 < 2 ? 2 : (radius / 2 > 16 ? 16 : radius / 2);
+    int outline = 4 * (steps + 1);
+    if (reserve(d, outline + 1, 3 * outline) != 0) return;
+    const float corner_x[4] = { r.x + radius, r.x + r.w - radius, r.x + r.w - radius, r.x + radius };
+    const float corner_y[4] = { r.y + radius, r.y + radius, r.y + r.h - radius, r.y + r.h - radius };
+    int center = vertex(d, r.x + r.w / 2.0f, r.y + r.h / 2.0f, color, 1.0f);
+    int first = d->vertex_count;
+    for (int k = 0; k < 4; ++k) {
+        /* top-left, top-right, bottom-right, bottom-left, clockwise on screen */
+        float start = PI * (1.0f + 0.5f * k);
+        for (int s = 0; s <= steps; ++s) {
+            float a = start + PI * 0.5f * s / steps;
+            vertex(d, corner_x[k] + radius * cosf(a), corner_y[k] + radius * sinf(a), color, 1.0f);
+        }
+    }
+    for (int i = 0; i < outline; ++i) triangle(d, center, first + i, first + (i + 1) % outline);
+}
+
+/* A band along the segment made of `rows` parallel lines at `offset` from it,
+   each with its own alpha */
+static void line_band(GuiDraw *d, float x0, float y0, float x1, float y1, const float *offset,
+                      const float *alpha, int rows, SDL_Color color) {
+    float dx = x1 - x0, dy = y1 - y0, len = sqrtf(dx * dx + dy * dy);
+    if (len <= 0.0f) return;
+    float nx = -dy / len, ny = dx / len;
+    if (reserve(d, 2 * rows, 6 * (rows - 1)) != 0) return;
+    int first = d->vertex_count;
+    for (int i = 0; i < rows; ++i) {
+        vertex(d, x0 + nx * offset[i], y0 + ny * offset[i], color, alpha[i]);
+        vertex(d, x1 + nx * offset[i], y1 + ny * offset[i], color, alpha[i]);
+    }
+    for (int i = 0; i + 1 < rows; ++i) {
+        int a = first + 2 * i;
+        quad(d, a, a + 1, a + 3, a + 2);
+    }
+}
+
+void gui_draw_line(GuiDraw *d, float x0, float y0, float x1, float y1, float width, SDL_Color color) {
+    const float offset[2] = { -width / 2, width / 2 }, alpha[2] = { 1.0f, 1.0f };
+    line_band(d, x0, y0, x1, y1, offset, alpha, 2, color);
+}
+
+void gui_draw_glow_line(GuiDraw *d, float x0, float y0, float x1, float y1, float width, SDL_Color color) {
+    const float offset[3] = { -width / 2, 0.0f, width / 2 }, alpha[3] = { 0.0f, 1.0f, 0.0f };
+    line_band(d, x0, y0, x1, y1, offset, alpha, 3, color);
+}
+
+/* Concentric circles at `radius + offset[i]`, joined into a band */
+static void ring_band(GuiDraw *d, float cx, float cy, float radius, const float *offset,
+                      const float *alpha, int rows, SDL_Color color) {
+    int segments = (int)radius;
+    if (segments < 16) segments = 16;
+    if (segments > 128) segments = 128;
+    if (reserve(d, rows * segments, 6 * (rows - 1) * segments) != 0) return;
+    int first = d->vertex_count;
+    for (int i = 0; i < rows; ++i) {
+        float r = radius + offset[i];
+        if (r < 0.0f) r = 0.0f;
+        for (int s = 0; s < segments; ++s) {
+            float a = 2.0f * PI * s / segments;
+            vertex(d, cx + r * cosf(a), cy + r * sinf(a), color, alpha[i]);
+        }
+    }
+    for (int i = 0; i + 1 < rows; ++i) {
+        int inner = first + i * segments, outer = inner + segments;
+        for (int s = 0; s < segments; ++s) {
+            int t = (s + 1) % segments;
+            quad(d, inner + s, outer + s, outer + t, inner + t);
+        }
+    }
+}
+
+void gui_draw_ring(GuiDraw *d, float cx, float cy, float radius, float width, SDL_Color color) {
+    const float offset[2] = { -width / 2, width / 2 }, alpha[2] = { 1.0f, 1.0f };
+    ring_band(d, cx, cy, radius, offset, alpha, 2, color);
+}
+
+void gui_draw_glow_ring(GuiDraw *d, float cx, float cy, float radius, float width, SDL_Color color) {
+    const float offset[3] = { -width / 2, 0.0f, width / 2 }, alpha[3] = { 0.0f, 1.0f, 0.0f };
+    ring_band(d, cx, cy, radius, offset, alpha, 3, color);
+}
+
+void gui_draw_flush(GuiDraw *d) {
+    if (d->index_count == 0) return;
+    SDL_SetRenderDrawBlendMode(d->ren, SDL_BLENDMODE_BLEND);
+    SDL_RenderGeometry(d->ren, NULL, d->vertices, d->vertex_count, d->indices, d->index_count);
+    d->vertex_count = d->index_count = 0;
+    d->draw_calls++;
+}
+
+unsigned long gui_draw_calls(const GuiDraw *d) {
+    return d->draw_calls;
+}
+
+/* Paints `paint` into a new w x h texture; NULL if render targets fail */
+static SDL_Texture *bake(GuiDraw *d, int w, int h, GuiPaintFn paint, const void *user) {
+    SDL_Texture *tex = SDL_CreateTexture(d->ren, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, w, h);
+    if (!tex) return NULL;
+    gui_draw_flush(d);
+    SDL_Texture *target = SDL_GetRenderTarget(d->ren);
+    if (SDL_SetRenderTarget(d->ren, tex) != 0) {
+        SDL_DestroyTexture(tex);
+        return NULL;
+    }
+    SDL_SetRenderDrawColor(d->ren, 0, 0, 0, 0);
+    SDL_RenderClear(d->ren);
+    paint(d, w, h, user);
+    gui_draw_flush(d);
+    SDL_SetRenderTarget(d->ren, target);
+
+    SDL_BlendMode premultiplied = SDL_ComposeCustomBlendMode(
+        SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+        SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+    if (SDL_SetTextureBlendMode(tex, premultiplied) != 0) SDL_SetTextureBlendMode(tex, SDL_BLENDMODE_BLEND);
+    return tex;
+}
+
+void gui_draw_cached(GuiDraw *d, int key, int w, int h, GuiPaintFn paint, const void *user,
+                     SDL_Rect dst, Uint8 alpha) {
+    CachedShape *c = NULL;
+    for (int i = 0; i < CACHE_SLOTS && !c; ++i)
+        if (d->cache[i].tex && d->cache[i].key == key) c = &d->cache[i];
+    if (!c && !d->no_targets) {
+        for (int i = 0; i < CACHE_SLOTS && !c; ++i)
+            if (!d->cache[i].tex) c = &d->cache[i];
+        if (!c) {
+            c = &d->cache[d->next_evict];
+            d->next_evict = (d->next_evict + 1) % CACHE_SLOTS;
+            SDL_DestroyTexture(c->tex);
+        }
+        c->key = key;
+        c->tex = bake(d, w, h, paint, user);
+        if (!c->tex) {
+            d->no_targets = 1;
+            c = NULL;
+        }
+    }
+
+    if (c) {
+        gui_draw_flush(d);
+        SDL_SetTextureColorMod(c->tex, alpha, alpha, alpha);     /* colors are premultiplied */
+        SDL_SetTextureAlphaMod(c->tex, alpha);
+        SDL_RenderCopy(d->ren, c->tex, NULL, &dst);
+        d->draw_calls++;
+        return;
+    }
+
+    d->origin_x = (float)dst.x;
+    d->origin_y = (float)dst.y;
+    d->scale_x = (float)dst.w / w;
+    d->scale_y = (float)dst.h / h;
+    d->fade = alpha / 255.0f;
+    paint(d, w, h, user);
+    d->origin_x = d->origin_y = 0.0f;
+    d->scale_x = d->scale_y = d->fade = 1.0f;
+}
+
+void gui_draw_reset(GuiDraw *d) {
+    for (int i = 0; i < CACHE_SLOTS; ++i) {
+        if (d->cache[i].tex) SDL_DestroyTexture(d->cache[i].tex);
+        d->cache[i].tex = NULL;
+    }
+    d->next_evict = 0;
+    d->no_targets = 0;
+}
+
+void gui_draw_destroy(GuiDraw *d) {
+    if (!d) return;
+    gui_draw_reset(d);
+    free(d->vertices);
+    free(d->indices);
+    free(d);
+}
@@ -0,0 +1,54 @@
+#ifndef GUI_DRAW_H
+#define GUI_DRAW_H
+
+#include <SDL.h>
+
+/* Shape drawing for the SDL GUIs in batches: each call appends triangles to
+   a vertex buffer, and gui_draw_flush submits them all in one
+   SDL_RenderGeometry call. Flush before drawing anything else (text,
+   SDL_RenderCopy, SDL_RenderPresent) so it lands on top of the shapes.
+   Needs SDL 2.0.18 or newer. */
+
+typedef struct GuiDraw GuiDraw;
+
+/* Shapes drawn with `ren`; NULL if out of memory */
+GuiDraw *gui_draw_create(SDL_Renderer *ren);
+
+void gui_draw_rect(GuiDraw *d, SDL_Rect r, SDL_Color color);
+void gui_draw_rounded_rect(GuiDraw *d, SDL_Rect r, int radius, SDL_Color color);
+
+/* Shades from `top` at the top edge to `bottom` at the bottom edge */
+void gui_draw_gradient_rect(GuiDraw *d, SDL_Rect r, SDL_Color top, SDL_Color bottom);
+
+/* A line `width` pixels thick; the glow version fades out towards its edges */
+void gui_draw_line(GuiDraw *d, float x0, float y0, float x1, float y1, float width, SDL_Color color);
+void gui_draw_glow_line(GuiDraw *d, float x0, float y0, float x1, float y1, float width, SDL_Color color);
+
+/* A circle outline `width` pixels thick centered on `radius`; the glow version
+   fades out towards its edges */
+void gui_draw_ring(GuiDraw *d, float cx, float cy, float radius, float width, SDL_Color color);
+void gui_draw_glow_ring(GuiDraw *d, float cx, float cy, float radius, float width, SDL_Color color);
+
+/* Submits the shapes drawn since the last flush */
+void gui_draw_flush(GuiDraw *d);
+
+/* Paints a static shape into the w x h box at the origin with the calls above */
+typedef void (*GuiPaintFn)(GuiDraw *d, int w, int h, const void *user);
+
+/* Draws the shape that `paint` makes, stretched to `dst` and faded by `alpha`.
+   The first call for `key` paints it into a texture, which later calls only
+   copy; the same key must always mean the same shape at the same size. */
+void gui_draw_cached(GuiDraw *d, int key, int w, int h, GuiPaintFn paint, const void *user,
+                     SDL_Rect dst, Uint8 alpha);
+
+/* SDL draw calls made so far: batches flushed and cached shapes copied */
+unsigned long gui_draw_calls(const GuiDraw *d);
+
+/* Drops the cached shapes, e.g. after SDL_RENDER_TARGETS_RESET or
+   SDL_RENDER_DEVICE_RESET; they are painted again on demand */
+void gui_draw_reset(GuiDraw *d);
+
+/* Frees `d` (may be NULL) and its textures; call before destroying the renderer */
+void gui_draw_destroy(GuiDraw *d);
+
+#endif /* GUI_DRAW_H */
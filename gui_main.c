@@ -6,6 +6,12 @@
 #include <math.h>
 #include "game.h"
 #include "ai.h"
+#include "metrics.h"
+#include "ponder.h"
+#include "timer.h"
+#include "gui_draw.h"
+#include "gui_text.h"
+#include "gui_profiler.h"
 
 /* Modern Tic-Tac-Toe with enhanced UI/UX
    - Dark modern theme with gradient accents
@@ -19,9 +25,29 @@
 static const int WINDOW_W = 800;
 static const int WINDOW_H = 900;
 
+// The loop sleeps in SDL_WaitEventTimeout while nothing changes or moves;
+// this is how long it waits at most before looking again
+#define IDLE_WAIT_MS 1000
+// Longest step an animation advances in one frame, so a stall doesn't skip it
+#define MAX_FRAME_DT (1.0f / 30.0f)
+// Vsync paces animated frames; without it they are spaced at least this far apart
+#define MIN_FRAME_MS 8
+
 typedef enum { SCENE_WELCOME, SCENE_MODE_SELECT, SCENE_AI_SELECT, SCENE_GAME, SCENE_POPUP } Scene;
 typedef enum { MODE_AI, MODE_TWO_PLAYER } GameMode;
 
+// Frame profile saved by F4, in the working directory
+#define PROFILE_CSV "gui_profile.csv"
+
+static GuiPhase scene_phase(Scene scene) {
+    switch (scene) {
+    case SCENE_WELCOME: return GUI_PHASE_WELCOME;
+    case SCENE_MODE_SELECT: return GUI_PHASE_MODE_SELECT;
+    case SCENE_AI_SELECT: return GUI_PHASE_AI_SELECT;
+    default: return GUI_PHASE_GAME;
+    }
+}
+
 typedef struct {
     int x_wins;
     int o_wins;
@@ -40,52 +66,19 @@ static const SDL_Color X_COLOR = {34, 211, 238, 255};          // Cyan for X
 static const SDL_Color O_COLOR = {251, 146, 60, 255};          // Orange for O
 static const SDL_Color CELL_HOVER = {51, 65, 85, 150};         // Hover effect
 
-static void draw_text(SDL_Renderer *ren, TTF_Font *font, const char *text, SDL_Color color, int x, int y, int center) {
-    if (!font) return;
-    SDL_Surface *surf = TTF_RenderUTF8_Blended(font, text, color);
-    if (!surf) return;
-    SDL_Texture *tex = SDL_CreateTextureFromSurface(ren, surf);
-    SDL_Rect dst = { x, y, surf->w, surf->h };
-    if (center) dst.x -= surf->w / 2;
-    SDL_FreeSurface(surf);
-    if (tex) {
-        SDL_RenderCopy(ren, tex, NULL, &dst);
-        SDL_DestroyTexture(tex);
-    }
-}
+static GuiDraw *shapes;  // batched shapes, see gui_draw.h
+static GuiText *texts;   // cached string textures and glyph atlases
 
-static void draw_rounded_rect(SDL_Renderer *ren, SDL_Rect r, int radius, SDL_Color color) {
-    SDL_SetRenderDrawColor(ren, color.r, color.g, color.b, color.a);
-    SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND);
-    
-    // Center rectangles
-    SDL_Rect inner = { r.x + radius, r.y, r.w - 2*radius, r.h };
-    SDL_RenderFillRect(ren, &inner);
-    inner = (SDL_Rect){ r.x, r.y + radius, r.w, r.h - 2*radius };
-    SDL_RenderFillRect(ren, &inner);
-    
-    // Corner circles
-    for (int dy = -radius; dy <= radius; ++dy) {
-        for (int dx = -radius; dx <= radius; ++dx) {
-            if (dx*dx + dy*dy <= radius*radius) {
-                SDL_RenderDrawPoint(ren, r.x + radius + dx, r.y + radius + dy);
-                SDL_RenderDrawPoint(ren, r.x + r.w - radius + dx, r.y + radius + dy);
-                SDL_RenderDrawPoint(ren, r.x + radius + dx, r.y + r.h - radius + dy);
-                SDL_RenderDrawPoint(ren, r.x + r.w - radius + dx, r.y + r.h - radius + dy);
-            }
-        }
-    }
+// Labels that stay the same; each is rasterized once
+static void draw_text(TTF_Font *font, const char *text, SDL_Color color, int x, int y, int center) {
+    gui_draw_flush(shapes);     // keep the text above the shapes queued so far
+    gui_text_draw(texts, font, text, color, x, y, center);
 }
 
-static void draw_gradient_rect(SDL_Renderer *ren, SDL_Rect r, SDL_Color c1, SDL_Color c2) {
-    for (int y = 0; y < r.h; ++y) {
-        float t = (float)y / r.h;
-        Uint8 red = (Uint8)(c1.r + (c2.r - c1.r) * t);
-        Uint8 green = (Uint8)(c1.g + (c2.g - c1.g) * t);
-        Uint8 blue = (Uint8)(c1.b + (c2.b - c1.b) * t);
-        SDL_SetRenderDrawColor(ren, red, green, blue, 255);
-        SDL_RenderDrawLine(ren, r.x, r.y + y, r.x + r.w, r.y + y);
-    }
+// Text that changes often (scores, status lines), drawn from a glyph atlas
+static void draw_live_text(TTF_Font *font, const char *text, SDL_Color color, int x, int y, int center) {
+    gui_draw_flush(shapes);
+    gui_text_draw_live(texts, font, text, color, x, y, center);
 }
 
 static void render_welcome(SDL_Renderer *ren, TTF_Font *font, TTF_Font *fontSmall, int mouseX, int mouseY, Score *score) {
@@ -95,20 +88,20 @@ static void render_welcome(SDL_Renderer *ren, TTF_Font *font, TTF_Font *fontSmal
     
     // Title card with gradient
     SDL_Rect titleBox = { 100, 80, 600, 120 };
-    draw_gradient_rect(ren, titleBox, ACCENT_PRIMARY, ACCENT_SECONDARY);
-    draw_rounded_rect(ren, titleBox, 20, (SDL_Color){0, 0, 0, 0}); // Border effect
+    gui_draw_gradient_rect(shapes, titleBox, ACCENT_PRIMARY, ACCENT_SECONDARY);
+    gui_draw_rounded_rect(shapes, titleBox, 20, (SDL_Color){0, 0, 0, 0}); // Border effect
     
-    draw_text(ren, font, "TIC TAC TOE", TEXT_PRIMARY, WINDOW_W/2, 110, 1);
-    draw_text(ren, fontSmall, "Modern strategy game", TEXT_SECONDARY, WINDOW_W/2, 155, 1);
+    draw_text(font, "TIC TAC TOE", TEXT_PRIMARY, WINDOW_W/2, 110, 1);
+    draw_text(fontSmall, "Modern strategy game", TEXT_SECONDARY, WINDOW_W/2, 155, 1);
     
     // Score display
     SDL_Rect scoreBox = { 100, 230, 600, 100 };
-    draw_rounded_rect(ren, scoreBox, 15, BG_CARD);
+    gui_draw_rounded_rect(shapes, scoreBox, 15, BG_CARD);
     
     char scoreText[64];
     snprintf(scoreText, sizeof(scoreText), "X: %d    Draws: %d    O: %d", 
              score->x_wins, score->draws, score->o_wins);
-    draw_text(ren, fontSmall, scoreText, TEXT_SECONDARY, WINDOW_W/2, 270, 1);
+    draw_live_text(fontSmall, scoreText, TEXT_SECONDARY, WINDOW_W/2, 270, 1);
     
     // Buttons
     SDL_Rect startBtn = { 250, 380, 300, 70 };
@@ -120,16 +113,16 @@ static void render_welcome(SDL_Renderer *ren, TTF_Font *font, TTF_Font *fontSmal
     
     // Start button
     if (startHover) {
-        draw_gradient_rect(ren, startBtn, ACCENT_PRIMARY, ACCENT_SECONDARY);
+        gui_draw_gradient_rect(shapes, startBtn, ACCENT_PRIMARY, ACCENT_SECONDARY);
     } else {
-        draw_rounded_rect(ren, startBtn, 15, ACCENT_PRIMARY);
+        gui_draw_rounded_rect(shapes, startBtn, 15, ACCENT_PRIMARY);
     }
-    draw_text(ren, font, "START GAME", TEXT_PRIMARY, WINDOW_W/2, startBtn.y + 20, 1);
+    draw_text(font, "START GAME", TEXT_PRIMARY, WINDOW_W/2, startBtn.y + 20, 1);
     
     // Exit button
     SDL_Color exitColor = exitHover ? (SDL_Color){71, 85, 105, 255} : BG_CARD;
-    draw_rounded_rect(ren, exitBtn, 15, exitColor);
-    draw_text(ren, font, "EXIT", TEXT_SECONDARY, WINDOW_W/2, exitBtn.y + 20, 1);
+    gui_draw_rounded_rect(shapes, exitBtn, 15, exitColor);
+    draw_text(font, "EXIT", TEXT_SECONDARY, WINDOW_W/2, exitBtn.y + 20, 1);
 }
 
 static void render_mode_select(SDL_Renderer *ren, TTF_Font *font, TTF_Font *fontSmall, int mouseX, int mouseY) {
@@ -138,8 +131,8 @@ static void render_mode_select(SDL_Renderer *ren, TTF_Font *font, TTF_Font *font
     SDL_RenderClear(ren);
     
     // Title
-    draw_text(ren, font, "SELECT GAME MODE", TEXT_PRIMARY, WINDOW_W/2, 100, 1);
-    draw_text(ren, fontSmall, "Choose how you want to play", TEXT_SECONDARY, WINDOW_W/2, 150, 1);
+    draw_text(font, "SELECT GAME MODE", TEXT_PRIMARY, WINDOW_W/2, 100, 1);
+    draw_text(fontSmall, "Choose how you want to play", TEXT_SECONDARY, WINDOW_W/2, 150, 1);
     
     // Mode buttons
     SDL_Rect aiBtn = { 150, 250, 500, 100 };
@@ -153,34 +146,34 @@ static void render_mode_select(SDL_Renderer *ren, TTF_Font *font, TTF_Font *font
     
     // AI Mode button
     if (aiHover) {
-        draw_gradient_rect(ren, aiBtn, ACCENT_PRIMARY, ACCENT_SECONDARY);
+        gui_draw_gradient_rect(shapes, aiBtn, ACCENT_PRIMARY, ACCENT_SECONDARY);
     } else {
-        draw_rounded_rect(ren, aiBtn, 15, BG_CARD);
+        gui_draw_rounded_rect(shapes, aiBtn, 15, BG_CARD);
     }
-    draw_text(ren, font, "VS AI", TEXT_PRIMARY, WINDOW_W/2, aiBtn.y + 20, 1);
-    draw_text(ren, fontSmall, "Play against unbeatable AI", TEXT_SECONDARY, WINDOW_W/2, aiBtn.y + 60, 1);
+    draw_text(font, "VS AI", TEXT_PRIMARY, WINDOW_W/2, aiBtn.y + 20, 1);
+    draw_text(fontSmall, "Play against unbeatable AI", TEXT_SECONDARY, WINDOW_W/2, aiBtn.y + 60, 1);
     
     // Two Player Mode button
     if (twoPlayerHover) {
-        draw_gradient_rect(ren, twoPlayerBtn, ACCENT_PRIMARY, ACCENT_SECONDARY);
+        gui_draw_gradient_rect(shapes, twoPlayerBtn, ACCENT_PRIMARY, ACCENT_SECONDARY);
     } else {
-        draw_rounded_rect(ren, twoPlayerBtn, 15, BG_CARD);
+        gui_draw_rounded_rect(shapes, twoPlayerBtn, 15, BG_CARD);
     }
-    draw_text(ren, font, "TWO PLAYERS", TEXT_PRIMARY, WINDOW_W/2, twoPlayerBtn.y + 20, 1);
-    draw_text(ren, fontSmall, "Play with a friend locally", TEXT_SECONDARY, WINDOW_W/2, twoPlayerBtn.y + 60, 1);
+    draw_text(font, "TWO PLAYERS", TEXT_PRIMARY, WINDOW_W/2, twoPlayerBtn.y + 20, 1);
+    draw_text(fontSmall, "Play with a friend locally", TEXT_SECONDARY, WINDOW_W/2, twoPlayerBtn.y + 60, 1);
     
     // Back button
     SDL_Color backColor = backHover ? (SDL_Color){71, 85, 105, 255} : BG_CARD;
-    draw_rounded_rect(ren, backBtn, 15, backColor);
-    draw_text(ren, font, "BACK", TEXT_SECONDARY, WINDOW_W/2, backBtn.y + 20, 1);
+    gui_draw_rounded_rect(shapes, backBtn, 15, backColor);
+    draw_text(font, "BACK", TEXT_SECONDARY, WINDOW_W/2, backBtn.y + 20, 1);
 }
 
 static void render_ai_select(SDL_Renderer *ren, TTF_Font *font, TTF_Font *fontSmall, int mouseX, int mouseY) {
     SDL_SetRenderDrawColor(ren, BG_DARK.r, BG_DARK.g, BG_DARK.b, 255);
     SDL_RenderClear(ren);
     
-    draw_text(ren, font, "SELECT AI TYPE", TEXT_PRIMARY, WINDOW_W/2, 80, 1);
-    draw_text(ren, fontSmall, "Choose your AI opponent", TEXT_SECONDARY, WINDOW_W/2, 130, 1);
+    draw_text(font, "SELECT AI TYPE", TEXT_PRIMARY, WINDOW_W/2, 80, 1);
+    draw_text(fontSmall, "Choose your AI opponent", TEXT_SECONDARY, WINDOW_W/2, 130, 1);
     
     SDL_Rect localBtn = { 100, 200, 600, 120 };
     SDL_Rect openaiBtn = { 100, 350, 600, 120 };
@@ -193,70 +186,141 @@ static void render_ai_select(SDL_Renderer *ren, TTF_Font *font, TTF_Font *fontSm
     
     // Local AI Button
     if (localHover) {
-        draw_gradient_rect(ren, localBtn, (SDL_Color){34, 197, 94, 255}, ACCENT_PRIMARY);
+        gui_draw_gradient_rect(shapes, localBtn, (SDL_Color){34, 197, 94, 255}, ACCENT_PRIMARY);
     } else {
-        draw_rounded_rect(ren, localBtn, 15, BG_CARD);
+        gui_draw_rounded_rect(shapes, localBtn, 15, BG_CARD);
     }
-    draw_text(ren, font, "LOCAL MINIMAX AI", TEXT_PRIMARY, WINDOW_W/2, localBtn.y + 30, 1);
-    draw_text(ren, fontSmall, "Unbeatable | Instant | Free", TEXT_SECONDARY, WINDOW_W/2, localBtn.y + 75, 1);
+    draw_text(font, "LOCAL MINIMAX AI", TEXT_PRIMARY, WINDOW_W/2, localBtn.y + 30, 1);
+    draw_text(fontSmall, "Unbeatable | Instant | Free", TEXT_SECONDARY, WINDOW_W/2, localBtn.y + 75, 1);
     
     // OpenAI Button
     if (openaiHover) {
-        draw_gradient_rect(ren, openaiBtn, ACCENT_SECONDARY, ACCENT_PRIMARY);
+        gui_draw_gradient_rect(shapes, openaiBtn, ACCENT_SECONDARY, ACCENT_PRIMARY);
     } else {
-        draw_rounded_rect(ren, openaiBtn, 15, BG_CARD);
+        gui_draw_rounded_rect(shapes, openaiBtn, 15, BG_CARD);
     }
-    draw_text(ren, font, "OPENAI GPT AI", TEXT_PRIMARY, WINDOW_W/2, openaiBtn.y + 30, 1);
-    draw_text(ren, fontSmall, "Creative | Requires API Key", TEXT_SECONDARY, WINDOW_W/2, openaiBtn.y + 75, 1);
+    draw_text(font, "OPENAI GPT AI", TEXT_PRIMARY, WINDOW_W/2, openaiBtn.y + 30, 1);
+    draw_text(fontSmall, "Creative | Requires API Key", TEXT_SECONDARY, WINDOW_W/2, openaiBtn.y + 75, 1);
     
     // Back button
     SDL_Color backColor = backHover ? (SDL_Color){71, 85, 105, 255} : BG_CARD;
-    draw_rounded_rect(ren, backBtn, 15, backColor);
-    draw_text(ren, font, "BACK", TEXT_SECONDARY, WINDOW_W/2, backBtn.y + 20, 1);
+    gui_draw_rounded_rect(shapes, backBtn, 15, backColor);
+    draw_text(font, "BACK", TEXT_SECONDARY, WINDOW_W/2, backBtn.y + 20, 1);
 }
 
-static void draw_X(SDL_Renderer *ren, SDL_Rect r, float scale, Uint8 alpha) {
-    SDL_SetRenderDrawColor(ren, X_COLOR.r, X_COLOR.g, X_COLOR.b, alpha);
-    SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND);
-    
-    int cx = r.x + r.w/2;
-    int cy = r.y + r.h/2;
-    int half = (int)(r.w/2 * 0.4 * scale);
-    
-    // Draw thicker X with glow
-    for (int t = -4; t <= 4; ++t) {
-        Uint8 glowAlpha = alpha * (1.0f - abs(t) / 5.0f);
-        SDL_SetRenderDrawColor(ren, X_COLOR.r, X_COLOR.g, X_COLOR.b, glowAlpha);
-        SDL_RenderDrawLine(ren, cx-half, cy-half+t, cx+half, cy+half+t);
-        SDL_RenderDrawLine(ren, cx-half, cy+half+t, cx+half, cy-half+t);
+// The pieces at full size in a w x h cell, with a glow fading out from the stroke
+static void paint_X(GuiDraw *d, int w, int h, const void *user) {
+    (void)user;
+    float cx = w / 2.0f, cy = h / 2.0f, half = w / 2 * 0.4f;
+    gui_draw_glow_line(d, cx - half, cy - half, cx + half, cy + half, 10.0f, X_COLOR);
+    gui_draw_glow_line(d, cx - half, cy + half, cx + half, cy - half, 10.0f, X_COLOR);
+}
+
+static void paint_O(GuiDraw *d, int w, int h, const void *user) {
+    (void)user;
+    gui_draw_glow_ring(d, w / 2.0f, h / 2.0f, w / 2 * 0.4f, 10.0f, O_COLOR);
+}
+
+// Draws a piece grown to `scale` of the cell from its center; the full-size
+// piece is painted once and then copied
+static void draw_piece(char piece, SDL_Rect r, float scale, Uint8 alpha) {
+    SDL_Rect dst = { 0, 0, (int)(r.w * scale), (int)(r.h * scale) };
+    if (dst.w <= 0 || dst.h <= 0) return;
+    dst.x = r.x + (r.w - dst.w) / 2;
+    dst.y = r.y + (r.h - dst.h) / 2;
+    gui_draw_cached(shapes, (piece << 16) | r.w, r.w, r.h, piece == 'X' ? paint_X : paint_O, NULL, dst, alpha);
+}
+
+// AI moves are computed on a worker thread and posted back as an SDL user
+// event, so the render loop never waits on the engine. Every request carries
+// the generation it was made in; leaving the game bumps the generation, the
+// worker stops early and any late result is ignored.
+typedef struct {
+    char board[9];
+    char ai, human;
+    int move;           // already known from pondering, or -1 to search
+    int generation;
+} AIRequest;
+
+#define AI_MIN_THINK_MS 300   // short pause so the AI move doesn't land instantly
+
+static Uint32 aiMoveEvent = (Uint32)-1;
+static SDL_atomic_t aiGeneration;
+
+static int ai_worker(void *arg) {
+    AIRequest *req = arg;
+    Uint32 start = SDL_GetTicks();
+    int mv = req->move >= 0 ? req->move : get_best_move(req->board, req->ai, req->human);
+    while (SDL_GetTicks() - start < AI_MIN_THINK_MS) {
+        if (SDL_AtomicGet(&aiGeneration) != req->generation) break;
+        SDL_Delay(10);
     }
+    if (SDL_AtomicGet(&aiGeneration) == req->generation) {
+        SDL_Event ev;
+        SDL_memset(&ev, 0, sizeof(ev));
+        ev.type = aiMoveEvent;
+        ev.user.code = mv;
+        ev.user.data1 = (void *)(intptr_t)req->generation;
+        SDL_PushEvent(&ev);
+    }
+    SDL_free(req);
+    return 0;
 }
 
-static void draw_O(SDL_Renderer *ren, SDL_Rect r, float scale, Uint8 alpha) {
-    SDL_SetRenderDrawColor(ren, O_COLOR.r, O_COLOR.g, O_COLOR.b, alpha);
-    SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND);
-    
-    int cx = r.x + r.w/2;
-    int cy = r.y + r.h/2;
-    int radius = (int)(r.w/2 * 0.4 * scale);
-    
-    // Draw circle with thickness and glow
-    for (int r_offset = -4; r_offset <= 4; ++r_offset) {
-        int curr_radius = radius + r_offset;
-        if (curr_radius < 0) continue;
-        Uint8 glowAlpha = alpha * (1.0f - abs(r_offset) / 5.0f);
-        SDL_SetRenderDrawColor(ren, O_COLOR.r, O_COLOR.g, O_COLOR.b, glowAlpha);
-        
-        for (int y = -curr_radius; y <= curr_radius; ++y) {
-            int dx = (int)(sqrt((double)(curr_radius*curr_radius - y*y)));
-            SDL_RenderDrawPoint(ren, cx-dx, cy+y);
-            SDL_RenderDrawPoint(ren, cx+dx, cy+y);
-        }
+// Drops any pending AI result and waits for the worker to finish
+static void cancel_ai(SDL_Thread **thread) {
+    SDL_AtomicAdd(&aiGeneration, 1);
+    if (*thread) {
+        SDL_WaitThread(*thread, NULL);
+        *thread = NULL;
+    }
+}
+
+// Starts the AI on `board`, which only waits out the think delay if `move` is
+// already known (>= 0); returns false if no worker could be started
+static bool start_ai(SDL_Thread **thread, const char board[9], char ai, char human, int move) {
+    cancel_ai(thread);
+    if (aiMoveEvent == (Uint32)-1) return false;
+    AIRequest *req = SDL_malloc(sizeof(*req));
+    if (!req) return false;
+    SDL_memcpy(req->board, board, 9);
+    req->ai = ai;
+    req->human = human;
+    req->move = move;
+    req->generation = SDL_AtomicGet(&aiGeneration);
+    *thread = SDL_CreateThread(ai_worker, "ai", req);
+    if (!*thread) {
+        SDL_free(req);
+        return false;
+    }
+    return true;
+}
+
+// Three dots pulsing in turn while the AI is thinking
+static void draw_thinking(int cx, int cy, Uint32 ticks) {
+    for (int i = 0; i < 3; ++i) {
+        float phase = (ticks % 900) / 900.0f * 6.2831853f - i * 0.9f;
+        float pulse = 0.5f + 0.5f * sinf(phase);
+        int size = 8 + (int)(4 * pulse);
+        SDL_Color c = ACCENT_PRIMARY;
+        c.a = (Uint8)(90 + 165 * pulse);
+        SDL_Rect dot = { cx + (i - 1) * 24 - size / 2, cy - size / 2, size, size };
+        gui_draw_rounded_rect(shapes, dot, size / 2, c);
     }
 }
 
 int main(int argc, char **argv) {
-    (void)argc; (void)argv;
+    // --stats records engine and frame-time metrics and prints them on exit;
+    // --no-ponder leaves the AI idle during the player's turn
+    bool use_ponder = true;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--stats") == 0 || strcmp(argv[i], "--stats=json") == 0) {
+            metrics_set_enabled(1);
+            metrics_dump_at_exit(stdout, argv[i][7] ? METRICS_JSON : METRICS_PROMETHEUS);
+        } else if (strcmp(argv[i], "--no-ponder") == 0) {
+            use_ponder = false;
+        }
+    }
     
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER) != 0) {
         fprintf(stderr, "SDL_Init Error: %s\n", SDL_GetError());
@@ -282,6 +346,15 @@ int main(int argc, char **argv) {
         return 1;
     }
 
+    shapes = gui_draw_create(ren);
+    texts = gui_text_create(ren);
+    GuiProfiler *prof = gui_profiler_create(shapes, texts);  // F3 shows it, F4 saves it
+    bool showProfiler = false;
+    if (!shapes || !texts || !prof) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
     const char *font_paths[] = {
         "C:/Windows/Fonts/arial.ttf",
         "C:/Windows/Fonts/segoeui.ttf",
@@ -290,11 +363,12 @@ int main(int argc, char **argv) {
         NULL
     };
     
-    TTF_Font *font = NULL, *fontSmall = NULL;
+    TTF_Font *font = NULL, *fontSmall = NULL, *fontTiny = NULL;
     for (int i = 0; font_paths[i]; ++i) {
         font = TTF_OpenFont(font_paths[i], 36);
         if (font) {
             fontSmall = TTF_OpenFont(font_paths[i], 24);
+            fontTiny = TTF_OpenFont(font_paths[i], 16);
             break;
         }
     }
@@ -317,13 +391,54 @@ int main(int argc, char **argv) {
     
     Score score = {0, 0, 0};
     
-    Uint32 lastTime = SDL_GetTicks();
+    const double counterHz = (double)SDL_GetPerformanceFrequency();
+    Uint64 lastCounter = SDL_GetPerformanceCounter();
+    bool dirty = true;       // something on screen changed since the last frame
+    bool animating = false;  // pieces still growing in or the thinking dots; redrawn every frame
+
+    aiMoveEvent = SDL_RegisterEvents(1);
+    SDL_Thread *aiThread = NULL;
+    bool aiPending = false;
+    Ponder *ponder = use_ponder ? ponder_create() : NULL;   // replies worked out during the player's turn
+    bool pondering = false;
+
+    static const double frame_bounds[] = { 0.001, 0.002, 0.004, 0.008, 0.0167, 0.033, 0.05, 0.1, 0.25 };
+    Metric *frameTime = metrics_histogram("gui_frame_seconds", "Time to handle events, update and render a frame",
+                                          frame_bounds, 9);
 
     while (running) {
-        while (SDL_PollEvent(&e)) {
+        // Sleep until an event arrives unless there is a frame to draw anyway
+        bool got = SDL_WaitEventTimeout(&e, (dirty || animating) ? 0 : IDLE_WAIT_MS) != 0;
+        uint64_t frameStart = timer_now_ns();
+        gui_profiler_begin_frame(prof);
+        for (; got; got = SDL_PollEvent(&e) != 0) {
+            dirty = true;  // hover, clicks, AI answers and window exposes all show up on screen
             if (e.type == SDL_QUIT) {
                 running = false;
             }
+            if (e.type == SDL_RENDER_TARGETS_RESET || e.type == SDL_RENDER_DEVICE_RESET) {
+                gui_draw_reset(shapes);  // the textures' contents are gone
+                gui_text_reset(texts);
+            }
+            if (e.type == aiMoveEvent && aiPending) {
+                // Only the answer to the latest request counts
+                int mv = e.user.code;
+                if ((intptr_t)e.user.data1 == SDL_AtomicGet(&aiGeneration) && scene == SCENE_GAME &&
+                    mv >= 0 && mv < 9 && board[mv] == ' ') {
+                    board[mv] = ai;
+                    place_scale[mv] = 0.0f;
+                    place_alpha[mv] = 0;
+                    player_can_move = 1;
+                    aiPending = false;
+                }
+            }
+            if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_F3) {
+                showProfiler = !showProfiler;
+            }
+            if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_F4) {
+                if (gui_profiler_write_csv(prof, PROFILE_CSV) == 0) printf("Frame profile written to %s\n", PROFILE_CSV);
+                else fprintf(stderr, "Could not write %s\n", PROFILE_CSV);
+            }
             if (e.type == SDL_MOUSEMOTION) {
                 mouseX = e.motion.x;
                 mouseY = e.motion.y;
@@ -456,9 +571,14 @@ int main(int argc, char **argv) {
             }
         }
 
+        gui_profiler_mark(prof, GUI_PHASE_EVENTS);
+
         Uint32 now = SDL_GetTicks();
-        float dt = (now - lastTime) / 1000.0f;
-        lastTime = now;
+        Uint64 counter = SDL_GetPerformanceCounter();
+        float dt = (float)((counter - lastCounter) / counterHz);
+        lastCounter = counter;
+        if (!animating) dt = 0.0f;  // time spent asleep doesn't advance animations
+        if (dt > MAX_FRAME_DT) dt = MAX_FRAME_DT;
 
         // Update animations
         for (int i = 0; i < 9; ++i) {
@@ -468,22 +588,49 @@ int main(int argc, char **argv) {
                     if (place_scale[i] > 1.0f) place_scale[i] = 1.0f;
                 }
                 if (place_alpha[i] < 255) {
-                    place_alpha[i] += (Uint8)(dt * 600);
+                    int a = place_alpha[i] + (int)(dt * 600);
+                    place_alpha[i] = (Uint8)(a > 255 ? 255 : a);
                 }
             }
         }
 
-        // AI turn (only in AI mode)
+        gui_profiler_mark(prof, GUI_PHASE_UPDATE);
+
+        // Leaving the game abandons any move still being computed
+        if (aiPending && scene != SCENE_GAME) {
+            cancel_ai(&aiThread);
+            aiPending = false;
+        }
+        if (pondering && scene != SCENE_GAME) {
+            ponder_stop(ponder);
+            pondering = false;
+        }
+
+        // Player's turn: search the AI's replies to each possible move meanwhile
         char w = check_winner(board);
-        if (gameMode == MODE_AI && !player_can_move && w == ' ' && scene == SCENE_GAME) {
-            SDL_Delay(300);
-            int mv = get_best_move(board, ai, human);
-            if (board[mv] == ' ') {
-                board[mv] = ai;
-                place_scale[mv] = 0.0f;
-                place_alpha[mv] = 0;
+        if (ponder && !pondering && gameMode == MODE_AI && player_can_move && w == ' ' && scene == SCENE_GAME) {
+            ponder_start(ponder, board, ai, human);
+            pondering = true;
+        }
+
+        // AI turn (only in AI mode); the worker answers with aiMoveEvent
+        if (gameMode == MODE_AI && !player_can_move && !aiPending && w == ' ' && scene == SCENE_GAME) {
+            int ready = -1;
+            if (pondering && !ponder_take(ponder, board, &ready, NULL)) ready = -1;
+            pondering = false;
+            if (start_ai(&aiThread, board, ai, human, ready)) {
+                aiPending = true;
+            } else {
+                // No worker available: answer in this frame
+                int mv = ready >= 0 ? ready : get_best_move(board, ai, human);
+                if (board[mv] == ' ') {
+                    board[mv] = ai;
+                    place_scale[mv] = 0.0f;
+                    place_alpha[mv] = 0;
+                }
+                player_can_move = 1;
+                dirty = true;
             }
-            player_can_move = 1;
         }
 
         // Check end game
@@ -493,8 +640,18 @@ int main(int argc, char **argv) {
             else if (w == 'O') score.o_wins++;
             else if (w == 'T') score.draws++;  // Fixed: properly handle draw
             scene = SCENE_POPUP;
+            dirty = true;
         }
 
+        gui_profiler_mark(prof, GUI_PHASE_AI);
+
+        // Nothing new to show: skip the frame and go back to sleep
+        animating = aiPending;
+        for (int i = 0; i < 9; ++i)
+            if (board[i] != ' ' && (place_scale[i] < 1.0f || place_alpha[i] < 255)) animating = true;
+        if (!dirty && !animating) continue;
+        dirty = false;
+
         // Render
         SDL_SetRenderDrawColor(ren, BG_DARK.r, BG_DARK.g, BG_DARK.b, 255);
         SDL_RenderClear(ren);
@@ -507,7 +664,7 @@ int main(int argc, char **argv) {
             render_ai_select(ren, font, fontSmall, mouseX, mouseY);
         } else {
             // Game header
-            draw_text(ren, font, "TIC TAC TOE", TEXT_PRIMARY, WINDOW_W/2, 50, 1);
+            draw_text(font, "TIC TAC TOE", TEXT_PRIMARY, WINDOW_W/2, 50, 1);
             
             char turnText[64];
             if (gameMode == MODE_TWO_PLAYER) {
@@ -519,31 +676,31 @@ int main(int argc, char **argv) {
                     snprintf(turnText, sizeof(turnText), "AI thinking...");
                 }
             }
-            draw_text(ren, fontSmall, turnText, TEXT_SECONDARY, WINDOW_W/2, 100, 1);
+            draw_live_text(fontSmall, turnText, TEXT_SECONDARY, WINDOW_W/2, 100, 1);
+            if (aiPending) draw_thinking(WINDOW_W/2, 240, now);
             
             // Score bar
             SDL_Rect scoreBar = { 200, 150, 400, 60 };
-            draw_rounded_rect(ren, scoreBar, 10, BG_CARD);
+            gui_draw_rounded_rect(shapes, scoreBar, 10, BG_CARD);
             char scoreText[64];
             snprintf(scoreText, sizeof(scoreText), "X: %d  |  Draws: %d  |  O: %d", 
                      score.x_wins, score.draws, score.o_wins);
-            draw_text(ren, fontSmall, scoreText, TEXT_SECONDARY, WINDOW_W/2, 170, 1);
+            draw_live_text(fontSmall, scoreText, TEXT_SECONDARY, WINDOW_W/2, 170, 1);
             
             // Game board
             int gridX = 150, gridY = 280, gridSize = 500;
             SDL_Rect gridBg = { gridX - 15, gridY - 15, gridSize + 30, gridSize + 30 };
-            draw_rounded_rect(ren, gridBg, 20, BG_CARD);
+            gui_draw_rounded_rect(shapes, gridBg, 20, BG_CARD);
             
             // Draw grid lines
-            SDL_SetRenderDrawColor(ren, GRID_COLOR.r, GRID_COLOR.g, GRID_COLOR.b, 255);
             for (int i = 1; i <= 2; ++i) {
                 int x = gridX + i * (gridSize / 3);
                 SDL_Rect vr = { x - 2, gridY, 4, gridSize };
-                SDL_RenderFillRect(ren, &vr);
+                gui_draw_rect(shapes, vr, GRID_COLOR);
                 
                 int y = gridY + i * (gridSize / 3);
                 SDL_Rect hr = { gridX, y - 2, gridSize, 4 };
-                SDL_RenderFillRect(ren, &hr);
+                gui_draw_rect(shapes, hr, GRID_COLOR);
             }
             
             // Draw hover effect
@@ -556,7 +713,7 @@ int main(int argc, char **argv) {
                     gridSize / 3,
                     gridSize / 3
                 };
-                draw_rounded_rect(ren, cell, 10, CELL_HOVER);
+                gui_draw_rounded_rect(shapes, cell, 10, CELL_HOVER);
             }
             
             // Draw pieces
@@ -571,22 +728,20 @@ int main(int argc, char **argv) {
                     };
                     
                     if (board[idx] == 'X') {
-                        draw_X(ren, cell, place_scale[idx], place_alpha[idx]);
+                        draw_piece('X', cell, place_scale[idx], place_alpha[idx]);
                     } else if (board[idx] == 'O') {
-                        draw_O(ren, cell, place_scale[idx], place_alpha[idx]);
+                        draw_piece('O', cell, place_scale[idx], place_alpha[idx]);
                     }
                 }
             }
             
             // End game popup
             if (scene == SCENE_POPUP) {
-                SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND);
-                SDL_SetRenderDrawColor(ren, 0, 0, 0, 180);
                 SDL_Rect overlay = { 0, 0, WINDOW_W, WINDOW_H };
-                SDL_RenderFillRect(ren, &overlay);
+                gui_draw_rect(shapes, overlay, (SDL_Color){0, 0, 0, 180});
                 
                 SDL_Rect popup = { 150, 300, 500, 250 };
-                draw_rounded_rect(ren, popup, 25, BG_CARD);
+                gui_draw_rounded_rect(shapes, popup, 25, BG_CARD);
                 
                 char msg[64];
                 w = check_winner(board);
@@ -609,17 +764,34 @@ int main(int argc, char **argv) {
                     }
                 }
                 
-                draw_text(ren, font, msg, resultColor, WINDOW_W/2, 360, 1);
-                draw_text(ren, fontSmall, "Click anywhere to continue", TEXT_SECONDARY, WINDOW_W/2, 480, 1);
+                draw_live_text(font, msg, resultColor, WINDOW_W/2, 360, 1);
+                draw_text(fontSmall, "Click anywhere to continue", TEXT_SECONDARY, WINDOW_W/2, 480, 1);
             }
         }
 
+        gui_draw_flush(shapes);
+        gui_profiler_mark(prof, scene_phase(scene));
+        if (showProfiler) {
+            gui_profiler_draw(prof, fontTiny);
+            gui_profiler_mark(prof, GUI_PHASE_OVERLAY);
+        }
         SDL_RenderPresent(ren);
-        SDL_Delay(16);
+        gui_profiler_mark(prof, GUI_PHASE_PRESENT);
+        gui_profiler_end_frame(prof);
+        gui_text_end_frame(texts);
+        double frameMs = timer_elapsed_ms(frameStart);
+        metrics_observe(frameTime, frameMs / 1000.0);
+        if (frameMs < MIN_FRAME_MS) SDL_Delay((Uint32)(MIN_FRAME_MS - frameMs));
     }
 
+    cancel_ai(&aiThread);
+    ponder_destroy(ponder);
     if (font) TTF_CloseFont(font);
     if (fontSmall) TTF_CloseFont(fontSmall);
+    if (fontTiny) TTF_CloseFont(fontTiny);
+    gui_profiler_destroy(prof);
+    gui_text_destroy(texts);
+    gui_draw_destroy(shapes);
     SDL_DestroyRenderer(ren);
     SDL_DestroyWindow(win);
     TTF_Quit();
@@ -7,6 +7,12 @@
 #include <stdlib.h>
 #include "game.h"
 #include "ai.h"
+#include "metrics.h"
+#include "ponder.h"
+#include "timer.h"
+#include "gui_draw.h"
+#include "gui_text.h"
+#include "gui_profiler.h"
 #include "openai_ai.h" /* optional; implement as a separate module if you want OpenAI support */
 
 /* Modern Tic-Tac-Toe with OpenAI Integration (completed)
@@ -23,11 +29,63 @@
    - This file expects game.h / ai.h to provide: init_board, check_winner, get_best_move.
 */
 
+// How long the GUI waits on OpenAI before the local AI moves instead
+#define OPENAI_DEADLINE_MS 8000
+
+// While the player thinks, OpenAI is asked ahead for its replies to the likeliest
+// moves, at most this many requests at a time
+#define OPENAI_PONDER_MAX 3
+
+// A speculative request starts before the player moves, so its transfer is allowed
+// this much time for the player to think on top of OPENAI_DEADLINE_MS; the deadline
+// itself still counts from the AI's turn
+#define OPENAI_SPEC_THINK_MS 30000
+
+// The loop sleeps in SDL_WaitEventTimeout while nothing changes or moves: at
+// most OPENAI_POLL_MS while requests are in flight or the AI's move is due, so
+// they are still polled, and IDLE_WAIT_MS otherwise
+#define OPENAI_POLL_MS 10
+#define IDLE_WAIT_MS 1000
+// Longest step an animation advances in one frame, so a stall doesn't skip it
+#define MAX_FRAME_DT (1.0f / 30.0f)
+// Vsync paces animated frames; without it they are spaced at least this far apart
+#define MIN_FRAME_MS 8
+
+// Drops the speculative requests except the one for the player's move `keep`
+// (-1 for none), which is returned unless it failed
+static OpenAIRequest *end_speculation(OpenAIRequest *spec[9], int keep) {
+    OpenAIRequest *kept = NULL;
+    for (int i = 0; i < 9; ++i) {
+        if (i == keep) kept = spec[i];
+        else openai_move_cancel(spec[i]);
+        spec[i] = NULL;
+    }
+    int mv;
+    OpenAIStatus st = kept ? openai_move_poll(kept, &mv) : OPENAI_FAILED;
+    if (st == OPENAI_FAILED) {
+        openai_move_cancel(kept);
+        kept = NULL;
+    }
+    return kept;
+}
+
 static const int WINDOW_W = 800;
 static const int WINDOW_H = 900;
 
 typedef enum { SCENE_WELCOME, SCENE_MODE_SELECT, SCENE_AI_SELECT, SCENE_GAME, SCENE_POPUP } Scene;
 typedef enum { MODE_AI, MODE_TWO_PLAYER } GameMode;
+
+// Frame profile saved by F4, in the working directory
+#define PROFILE_CSV "gui_profile.csv"
+
+static GuiPhase scene_phase(Scene scene) {
+    switch (scene) {
+    case SCENE_WELCOME: return GUI_PHASE_WELCOME;
+    case SCENE_MODE_SELECT: return GUI_PHASE_MODE_SELECT;
+    case SCENE_AI_SELECT: return GUI_PHASE_AI_SELECT;
+    default: return GUI_PHASE_GAME;
+    }
+}
 typedef enum { AI_LOCAL, AI_OPENAI } AIType;
 
 typedef struct {
@@ -50,50 +108,19 @@ static const SDL_Color CELL_HOVER = {51, 65, 85, 150};
 static const SDL_Color SUCCESS_COLOR = {34, 197, 94, 255};
 static const SDL_Color WARNING_COLOR = {234, 179, 8, 255};
 
-static void draw_text(SDL_Renderer *ren, TTF_Font *font, const char *text, SDL_Color color, int x, int y, int center) {
-    if (!font || !text) return;
-    SDL_Surface *surf = TTF_RenderUTF8_Blended(font, text, color);
-    if (!surf) return;
-    SDL_Texture *tex = SDL_CreateTextureFromSurface(ren, surf);
-    SDL_Rect dst = { x, y, surf->w, surf->h };
-    if (center) dst.x -= surf->w / 2;
-    SDL_FreeSurface(surf);
-    if (tex) {
-        SDL_RenderCopy(ren, tex, NULL, &dst);
-        SDL_DestroyTexture(tex);
-    }
-}
+static GuiDraw *shapes;  // batched shapes, see gui_draw.h
+static GuiText *texts;   // cached string textures and glyph atlases
 
-static void draw_rounded_rect(SDL_Renderer *ren, SDL_Rect r, int radius, SDL_Color color) {
-    SDL_SetRenderDrawColor(ren, color.r, color.g, color.b, color.a);
-    SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND);
-
-    SDL_Rect inner = { r.x + radius, r.y, r.w - 2*radius, r.h };
-    SDL_RenderFillRect(ren, &inner);
-    inner = (SDL_Rect){ r.x, r.y + radius, r.w, r.h - 2*radius };
-    SDL_RenderFillRect(ren, &inner);
-
-    for (int dy = -radius; dy <= radius; ++dy) {
-        for (int dx = -radius; dx <= radius; ++dx) {
-            if (dx*dx + dy*dy <= radius*radius) {
-                SDL_RenderDrawPoint(ren, r.x + radius + dx, r.y + radius + dy);
-                SDL_RenderDrawPoint(ren, r.x + r.w - radius + dx, r.y + radius + dy);
-                SDL_RenderDrawPoint(ren, r.x + radius + dx, r.y + r.h - radius + dy);
-                SDL_RenderDrawPoint(ren, r.x + r.w - radius + dx, r.y + r.h - radius + dy);
-            }
-        }
-    }
+// Labels that stay the same; each is rasterized once
+static void draw_text(TTF_Font *font, const char *text, SDL_Color color, int x, int y, int center) {
+    gui_draw_flush(shapes);     // keep the text above the shapes queued so far
+    gui_text_draw(texts, font, text, color, x, y, center);
 }
 
-static void draw_gradient_rect(SDL_Renderer *ren, SDL_Rect r, SDL_Color c1, SDL_Color c2) {
-    for (int y = 0; y < r.h; ++y) {
-        float t = (float)y / (float)r.h;
-        Uint8 red = (Uint8)(c1.r + (c2.r - c1.r) * t);
-        Uint8 green = (Uint8)(c1.g + (c2.g - c1.g) * t);
-        Uint8 blue = (Uint8)(c1.b + (c2.b - c1.b) * t);
-        SDL_SetRenderDrawColor(ren, red, green, blue, 255);
-        SDL_RenderDrawLine(ren, r.x, r.y + y, r.x + r.w, r.y + y);
-    }
+// Text that changes often (scores, status lines), drawn from a glyph atlas
+static void draw_live_text(TTF_Font *font, const char *text, SDL_Color color, int x, int y, int center) {
+    gui_draw_flush(shapes);
+    gui_text_draw_live(texts, font, text, color, x, y, center);
 }
 
 static void render_welcome(SDL_Renderer *ren, TTF_Font *font, TTF_Font *fontSmall, int mouseX, int mouseY, Score *score) {
@@ -101,18 +128,18 @@ static void render_welcome(SDL_Renderer *ren, TTF_Font *font, TTF_Font *fontSmal
     SDL_RenderClear(ren);
 
     SDL_Rect titleBox = { 100, 80, 600, 120 };
-    draw_gradient_rect(ren, titleBox, ACCENT_PRIMARY, ACCENT_SECONDARY);
+    gui_draw_gradient_rect(shapes, titleBox, ACCENT_PRIMARY, ACCENT_SECONDARY);
 
-    draw_text(ren, font, "TIC TAC TOE", TEXT_PRIMARY, WINDOW_W/2, 110, 1);
-    draw_text(ren, fontSmall, "Modern strategy game with AI", TEXT_SECONDARY, WINDOW_W/2, 155, 1);
+    draw_text(font, "TIC TAC TOE", TEXT_PRIMARY, WINDOW_W/2, 110, 1);
+    draw_text(fontSmall, "Modern strategy game with AI", TEXT_SECONDARY, WINDOW_W/2, 155, 1);
 
     SDL_Rect scoreBox = { 100, 230, 600, 100 };
-    draw_rounded_rect(ren, scoreBox, 15, BG_CARD);
+    gui_draw_rounded_rect(shapes, scoreBox, 15, BG_CARD);
 
     char scoreText[64];
     snprintf(scoreText, sizeof(scoreText), "X: %d    Draws: %d    O: %d",
              score->x_wins, score->draws, score->o_wins);
-    draw_text(ren, fontSmall, scoreText, TEXT_SECONDARY, WINDOW_W/2, 270, 1);
+    draw_live_text(fontSmall, scoreText, TEXT_SECONDARY, WINDOW_W/2, 270, 1);
 
     SDL_Rect startBtn = { 250, 380, 300, 70 };
     SDL_Rect exitBtn = { 250, 480, 300, 70 };
@@ -122,23 +149,23 @@ static void render_welcome(SDL_Renderer *ren, TTF_Font *font, TTF_Font *fontSmal
     bool exitHover = SDL_PointInRect(&mp, &exitBtn);
 
     if (startHover) {
-        draw_gradient_rect(ren, startBtn, ACCENT_PRIMARY, ACCENT_SECONDARY);
+        gui_draw_gradient_rect(shapes, startBtn, ACCENT_PRIMARY, ACCENT_SECONDARY);
     } else {
-        draw_rounded_rect(ren, startBtn, 15, ACCENT_PRIMARY);
+        gui_draw_rounded_rect(shapes, startBtn, 15, ACCENT_PRIMARY);
     }
-    draw_text(ren, font, "START GAME", TEXT_PRIMARY, WINDOW_W/2, startBtn.y + 20, 1);
+    draw_text(font, "START GAME", TEXT_PRIMARY, WINDOW_W/2, startBtn.y + 20, 1);
 
     SDL_Color exitColor = exitHover ? (SDL_Color){71, 85, 105, 255} : BG_CARD;
-    draw_rounded_rect(ren, exitBtn, 15, exitColor);
-    draw_text(ren, font, "EXIT", TEXT_SECONDARY, WINDOW_W/2, exitBtn.y + 20, 1);
+    gui_draw_rounded_rect(shapes, exitBtn, 15, exitColor);
+    draw_text(font, "EXIT", TEXT_SECONDARY, WINDOW_W/2, exitBtn.y + 20, 1);
 }
 
 static void render_mode_select(SDL_Renderer *ren, TTF_Font *font, TTF_Font *fontSmall, int mouseX, int mouseY) {
     SDL_SetRenderDrawColor(ren, BG_DARK.r, BG_DARK.g, BG_DARK.b, 255);
     SDL_RenderClear(ren);
 
-    draw_text(ren, font, "SELECT GAME MODE", TEXT_PRIMARY, WINDOW_W/2, 100, 1);
-    draw_text(ren, fontSmall, "Choose how you want to play", TEXT_SECONDARY, WINDOW_W/2, 150, 1);
+    draw_text(font, "SELECT GAME MODE", TEXT_PRIMARY, WINDOW_W/2, 100, 1);
+    draw_text(fontSmall, "Choose how you want to play", TEXT_SECONDARY, WINDOW_W/2, 150, 1);
 
     SDL_Rect aiBtn = { 150, 250, 500, 100 };
     SDL_Rect twoPlayerBtn = { 150, 380, 500, 100 };
@@ -150,32 +177,32 @@ static void render_mode_select(SDL_Renderer *ren, TTF_Font *font, TTF_Font *font
     bool backHover = SDL_PointInRect(&mp, &backBtn);
 
     if (aiHover) {
-        draw_gradient_rect(ren, aiBtn, ACCENT_PRIMARY, ACCENT_SECONDARY);
+        gui_draw_gradient_rect(shapes, aiBtn, ACCENT_PRIMARY, ACCENT_SECONDARY);
     } else {
-        draw_rounded_rect(ren, aiBtn, 15, BG_CARD);
+        gui_draw_rounded_rect(shapes, aiBtn, 15, BG_CARD);
     }
-    draw_text(ren, font, "VS AI", TEXT_PRIMARY, WINDOW_W/2, aiBtn.y + 20, 1);
-    draw_text(ren, fontSmall, "Play against AI opponent", TEXT_SECONDARY, WINDOW_W/2, aiBtn.y + 60, 1);
+    draw_text(font, "VS AI", TEXT_PRIMARY, WINDOW_W/2, aiBtn.y + 20, 1);
+    draw_text(fontSmall, "Play against AI opponent", TEXT_SECONDARY, WINDOW_W/2, aiBtn.y + 60, 1);
 
     if (twoPlayerHover) {
-        draw_gradient_rect(ren, twoPlayerBtn, ACCENT_PRIMARY, ACCENT_SECONDARY);
+        gui_draw_gradient_rect(shapes, twoPlayerBtn, ACCENT_PRIMARY, ACCENT_SECONDARY);
     } else {
-        draw_rounded_rect(ren, twoPlayerBtn, 15, BG_CARD);
+        gui_draw_rounded_rect(shapes, twoPlayerBtn, 15, BG_CARD);
     }
-    draw_text(ren, font, "TWO PLAYERS", TEXT_PRIMARY, WINDOW_W/2, twoPlayerBtn.y + 20, 1);
-    draw_text(ren, fontSmall, "Play with a friend locally", TEXT_SECONDARY, WINDOW_W/2, twoPlayerBtn.y + 60, 1);
+    draw_text(font, "TWO PLAYERS", TEXT_PRIMARY, WINDOW_W/2, twoPlayerBtn.y + 20, 1);
+    draw_text(fontSmall, "Play with a friend locally", TEXT_SECONDARY, WINDOW_W/2, twoPlayerBtn.y + 60, 1);
 
     SDL_Color backColor = backHover ? (SDL_Color){71, 85, 105, 255} : BG_CARD;
-    draw_rounded_rect(ren, backBtn, 15, backColor);
-    draw_text(ren, font, "BACK", TEXT_SECONDARY, WINDOW_W/2, backBtn.y + 20, 1);
+    gui_draw_rounded_rect(shapes, backBtn, 15, backColor);
+    draw_text(font, "BACK", TEXT_SECONDARY, WINDOW_W/2, backBtn.y + 20, 1);
 }
 
 static void render_ai_select(SDL_Renderer *ren, TTF_Font *font, TTF_Font *fontSmall, TTF_Font *fontTiny, int mouseX, int mouseY) {
     SDL_SetRenderDrawColor(ren, BG_DARK.r, BG_DARK.g, BG_DARK.b, 255);
     SDL_RenderClear(ren);
 
-    draw_text(ren, font, "SELECT AI TYPE", TEXT_PRIMARY, WINDOW_W/2, 80, 1);
-    draw_text(ren, fontSmall, "Choose your AI opponent", TEXT_SECONDARY, WINDOW_W/2, 130, 1);
+    draw_text(font, "SELECT AI TYPE", TEXT_PRIMARY, WINDOW_W/2, 80, 1);
+    draw_text(fontSmall, "Choose your AI opponent", TEXT_SECONDARY, WINDOW_W/2, 130, 1);
 
     SDL_Rect localBtn = { 100, 200, 600, 120 };
     SDL_Rect openaiBtn = { 100, 350, 600, 120 };
@@ -188,63 +215,61 @@ static void render_ai_select(SDL_Renderer *ren, TTF_Font *font, TTF_Font *fontSm
 
     // Local AI Button
     if (localHover) {
-        draw_gradient_rect(ren, localBtn, SUCCESS_COLOR, ACCENT_PRIMARY);
+        gui_draw_gradient_rect(shapes, localBtn, SUCCESS_COLOR, ACCENT_PRIMARY);
     } else {
-        draw_rounded_rect(ren, localBtn, 15, BG_CARD);
+        gui_draw_rounded_rect(shapes, localBtn, 15, BG_CARD);
     }
-    draw_text(ren, font, "LOCAL MINIMAX AI", TEXT_PRIMARY, WINDOW_W/2, localBtn.y + 25, 1);
-    draw_text(ren, fontSmall, "Unbeatable | Instant | Free", SUCCESS_COLOR, WINDOW_W/2, localBtn.y + 65, 1);
-    draw_text(ren, fontTiny, "Perfect play, no internet required", TEXT_SECONDARY, WINDOW_W/2, localBtn.y + 92, 1);
+    draw_text(font, "LOCAL MINIMAX AI", TEXT_PRIMARY, WINDOW_W/2, localBtn.y + 25, 1);
+    draw_text(fontSmall, "Unbeatable | Instant | Free", SUCCESS_COLOR, WINDOW_W/2, localBtn.y + 65, 1);
+    draw_text(fontTiny, "Perfect play, no internet required", TEXT_SECONDARY, WINDOW_W/2, localBtn.y + 92, 1);
 
     // OpenAI Button
     if (openaiHover) {
-        draw_gradient_rect(ren, openaiBtn, ACCENT_SECONDARY, ACCENT_PRIMARY);
+        gui_draw_gradient_rect(shapes, openaiBtn, ACCENT_SECONDARY, ACCENT_PRIMARY);
     } else {
-        draw_rounded_rect(ren, openaiBtn, 15, BG_CARD);
+        gui_draw_rounded_rect(shapes, openaiBtn, 15, BG_CARD);
     }
-    draw_text(ren, font, "OPENAI GPT AI", TEXT_PRIMARY, WINDOW_W/2, openaiBtn.y + 25, 1);
-    draw_text(ren, fontSmall, "Creative | Explains Moves | requires internet", WARNING_COLOR, WINDOW_W/2, openaiBtn.y + 65, 1);
-    draw_text(ren, fontTiny, "Powered by a remote model", TEXT_SECONDARY, WINDOW_W/2, openaiBtn.y + 92, 1);
+    draw_text(font, "OPENAI GPT AI", TEXT_PRIMARY, WINDOW_W/2, openaiBtn.y + 25, 1);
+    draw_text(fontSmall, "Creative | Explains Moves | requires internet", WARNING_COLOR, WINDOW_W/2, openaiBtn.y + 65, 1);
+    draw_text(fontTiny, "Powered by a remote model", TEXT_SECONDARY, WINDOW_W/2, openaiBtn.y + 92, 1);
 
     // Back button
     SDL_Color backColor = backHover ? (SDL_Color){71, 85, 105, 255} : BG_CARD;
-    draw_rounded_rect(ren, backBtn, 15, backColor);
-    draw_text(ren, font, "BACK", TEXT_SECONDARY, WINDOW_W/2, backBtn.y + 20, 1);
+    gui_draw_rounded_rect(shapes, backBtn, 15, backColor);
+    draw_text(font, "BACK", TEXT_SECONDARY, WINDOW_W/2, backBtn.y + 20, 1);
 }
 
-static void draw_X(SDL_Renderer *ren, SDL_Rect r, float scale, Uint8 alpha) {
-    SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND);
-    int cx = r.x + r.w/2;
-    int cy = r.y + r.h/2;
-    int half = (int)(r.w/2 * 0.4f * scale);
-    for (int t = -4; t <= 4; ++t) {
-        Uint8 glowAlpha = (Uint8)(alpha * (1.0f - fabsf((float)t) / 5.0f));
-        SDL_SetRenderDrawColor(ren, X_COLOR.r, X_COLOR.g, X_COLOR.b, glowAlpha);
-        SDL_RenderDrawLine(ren, cx-half, cy-half+t, cx+half, cy+half+t);
-        SDL_RenderDrawLine(ren, cx-half, cy+half+t, cx+half, cy-half+t);
-    }
+// The pieces at full size in a w x h cell, with a glow fading out from the stroke
+static void paint_X(GuiDraw *d, int w, int h, const void *user) {
+    (void)user;
+    float cx = w / 2.0f, cy = h / 2.0f, half = w / 2 * 0.4f;
+    gui_draw_glow_line(d, cx - half, cy - half, cx + half, cy + half, 10.0f, X_COLOR);
+    gui_draw_glow_line(d, cx - half, cy + half, cx + half, cy - half, 10.0f, X_COLOR);
 }
 
-static void draw_O(SDL_Renderer *ren, SDL_Rect r, float scale, Uint8 alpha) {
-    SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND);
-    int cx = r.x + r.w/2;
-    int cy = r.y + r.h/2;
-    int radius = (int)(r.w/2 * 0.4f * scale);
-    for (int r_offset = -4; r_offset <= 4; ++r_offset) {
-        int curr_radius = radius + r_offset;
-        if (curr_radius < 0) continue;
-        Uint8 glowAlpha = (Uint8)(alpha * (1.0f - fabsf((float)r_offset) / 5.0f));
-        SDL_SetRenderDrawColor(ren, O_COLOR.r, O_COLOR.g, O_COLOR.b, glowAlpha);
-        for (int y = -curr_radius; y <= curr_radius; ++y) {
-            int dx = (int)(sqrt((double)(curr_radius*curr_radius - y*y)));
-            SDL_RenderDrawPoint(ren, cx-dx, cy+y);
-            SDL_RenderDrawPoint(ren, cx+dx, cy+y);
-        }
-    }
+static void paint_O(GuiDraw *d, int w, int h, const void *user) {
+    (void)user;
+    gui_draw_glow_ring(d, w / 2.0f, h / 2.0f, w / 2 * 0.4f, 10.0f, O_COLOR);
+}
+
+// Draws a piece grown to `scale` of the cell from its center; the full-size
+// piece is painted once and then copied
+static void draw_piece(char piece, SDL_Rect r, float scale, Uint8 alpha) {
+    SDL_Rect dst = { 0, 0, (int)(r.w * scale), (int)(r.h * scale) };
+    if (dst.w <= 0 || dst.h <= 0) return;
+    dst.x = r.x + (r.w - dst.w) / 2;
+    dst.y = r.y + (r.h - dst.h) / 2;
+    gui_draw_cached(shapes, (piece << 16) | r.w, r.w, r.h, piece == 'X' ? paint_X : paint_O, NULL, dst, alpha);
 }
 
 int main(int argc, char **argv) {
-    (void)argc; (void)argv;
+    // --stats records engine, OpenAI and frame-time metrics and prints them on exit
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--stats") == 0 || strcmp(argv[i], "--stats=json") == 0) {
+            metrics_set_enabled(1);
+            metrics_dump_at_exit(stdout, argv[i][7] ? METRICS_JSON : METRICS_PROMETHEUS);
+        }
+    }
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER) != 0) {
         fprintf(stderr, "SDL_Init Error: %s\n", SDL_GetError());
         return 1;
@@ -261,6 +286,7 @@ int main(int argc, char **argv) {
     if (api_key && strlen(api_key) > 0) {
         if (openai_init(api_key) == 0) openai_available = true;
     }
+    if (openai_available) openai_enable_cache("openai_moves.cache", 30L * 24 * 3600);
 
     SDL_Window *win = SDL_CreateWindow("Tic-Tac-Toe with OpenAI", SDL_WINDOWPOS_CENTERED,
                                        SDL_WINDOWPOS_CENTERED, WINDOW_W, WINDOW_H, SDL_WINDOW_SHOWN);
@@ -275,6 +301,15 @@ int main(int argc, char **argv) {
         return 1;
     }
 
+    shapes = gui_draw_create(ren);
+    texts = gui_text_create(ren);
+    GuiProfiler *prof = gui_profiler_create(shapes, texts);  // F3 shows it, F4 saves it
+    bool showProfiler = false;
+    if (!shapes || !texts || !prof) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
     const char *font_paths[] = {
         "C:/Windows/Fonts/arial.ttf",
         "C:/Windows/Fonts/segoeui.ttf",
@@ -316,14 +351,44 @@ int main(int argc, char **argv) {
     int hover_cell = -1;
 
     Score score = {0,0,0};
-    Uint32 lastTime = SDL_GetTicks();
+    const double counterHz = (double)SDL_GetPerformanceFrequency();
+    Uint64 lastCounter = SDL_GetPerformanceCounter();
+    bool dirty = true;       // something on screen changed since the last frame
+    bool animating = false;  // pieces still growing in; redrawn every frame
+    bool polling = false;    // OpenAI requests or the AI's move to check on
     Uint32 aiThinkStartTime = 0;
+    OpenAIRequest *aiRequest = NULL;   // OpenAI move in flight, polled every frame
+    int aiMove = -1;                   // chosen move waiting for the think delay
+    OpenAIRequest *spec[9] = {NULL};   // speculative replies, by the player's move
+    int specOrder[9], specCount = 0, specNext = 0;
+    bool speculating = false;
+
+    static const double frame_bounds[] = { 0.001, 0.002, 0.004, 0.008, 0.0167, 0.033, 0.05, 0.1, 0.25 };
+    Metric *frameTime = metrics_histogram("gui_frame_seconds", "Time to handle events, update and render a frame",
+                                          frame_bounds, 9);
 
     while (running) {
-        while (SDL_PollEvent(&e)) {
+        // Sleep until an event arrives unless there is a frame to draw or work to poll
+        int waitMs = (dirty || animating) ? 0 : polling ? OPENAI_POLL_MS : IDLE_WAIT_MS;
+        bool got = SDL_WaitEventTimeout(&e, waitMs) != 0;
+        uint64_t frameStart = timer_now_ns();
+        gui_profiler_begin_frame(prof);
+        for (; got; got = SDL_PollEvent(&e) != 0) {
+            dirty = true;  // hover, clicks and window exposes all show up on screen
             if (e.type == SDL_QUIT) {
                 running = false;
             }
+            if (e.type == SDL_RENDER_TARGETS_RESET || e.type == SDL_RENDER_DEVICE_RESET) {
+                gui_draw_reset(shapes);  // the textures' contents are gone
+                gui_text_reset(texts);
+            }
+            if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_F3) {
+                showProfiler = !showProfiler;
+            }
+            if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_F4) {
+                if (gui_profiler_write_csv(prof, PROFILE_CSV) == 0) printf("Frame profile written to %s\n", PROFILE_CSV);
+                else fprintf(stderr, "Could not write %s\n", PROFILE_CSV);
+            }
             if (e.type == SDL_MOUSEMOTION) {
                 mouseX = e.motion.x;
                 mouseY = e.motion.y;
@@ -410,6 +475,12 @@ int main(int argc, char **argv) {
                                 board[idx] = human;
                                 place_scale[idx] = 0.0f; place_alpha[idx] = 0;
                                 player_can_move = 0; ai_thinking = true; aiThinkStartTime = SDL_GetTicks();
+                                if (speculating) {
+                                    // The reply to this move may be on its way already
+                                    openai_move_cancel(aiRequest);
+                                    aiRequest = end_speculation(spec, idx);
+                                    speculating = false;
+                                }
                             }
                         }
                     }
@@ -422,9 +493,14 @@ int main(int argc, char **argv) {
             }
         }
 
+        gui_profiler_mark(prof, GUI_PHASE_EVENTS);
+
         Uint32 now = SDL_GetTicks();
-        float dt = (now - lastTime) / 1000.0f;
-        lastTime = now;
+        Uint64 counter = SDL_GetPerformanceCounter();
+        float dt = (float)((counter - lastCounter) / counterHz);
+        lastCounter = counter;
+        if (!animating) dt = 0.0f;  // time spent asleep doesn't advance animations
+        if (dt > MAX_FRAME_DT) dt = MAX_FRAME_DT;
 
         // Update animations
         for (int i = 0; i < 9; ++i) {
@@ -442,25 +518,73 @@ int main(int argc, char **argv) {
             }
         }
 
-        // AI turn (only in AI mode)
+        gui_profiler_mark(prof, GUI_PHASE_UPDATE);
+
+        // A finished or abandoned game drops whatever the AI was working on
+        if (!ai_thinking || scene != SCENE_GAME) {
+            openai_move_cancel(aiRequest);
+            aiRequest = NULL;
+            aiMove = -1;
+        }
+
+        if (speculating && (!player_can_move || scene != SCENE_GAME)) {
+            end_speculation(spec, -1);
+            speculating = false;
+        }
         char w = check_winner(board);
+        polling = ai_thinking;
+
+        // Player's turn against OpenAI: keep up to OPENAI_PONDER_MAX requests going for
+        // replies to the likeliest moves; answers land in the move cache as they arrive
+        if (gameMode == MODE_AI && aiType == AI_OPENAI && openai_available && player_can_move &&
+            w == ' ' && scene == SCENE_GAME) {
+            if (!speculating) {
+                specCount = ponder_candidates(board, human, ai, specOrder);
+                specNext = 0;
+                speculating = true;
+            }
+            int inFlight = 0, mv;
+            for (int i = 0; i < 9; ++i)
+                if (spec[i] && openai_move_poll(spec[i], &mv) == OPENAI_PENDING) inFlight++;
+            while (inFlight < OPENAI_PONDER_MAX && specNext < specCount) {
+                int cell = specOrder[specNext++];
+                char next[9];
+                memcpy(next, board, 9);
+                next[cell] = human;
+                if (check_winner(next) != ' ') continue;
+                spec[cell] = openai_move_start(next, ai, human, OPENAI_SPEC_THINK_MS + OPENAI_DEADLINE_MS);
+                if (spec[cell] && openai_move_poll(spec[cell], &mv) == OPENAI_PENDING) inFlight++;
+            }
+            if (inFlight > 0) polling = true;
+        }
+
+        // AI turn (only in AI mode). An OpenAI request is started once and polled
+        // each frame, so the loop never waits on the network; the local AI only
+        // steps in if it fails or the deadline passes.
         if (gameMode == MODE_AI && ai_thinking && w == ' ' && scene == SCENE_GAME) {
-            if (now - aiThinkStartTime > (aiType == AI_OPENAI ? 500 : 300)) {
-                int mv = -1;
-                if (aiType == AI_OPENAI && openai_available) {
-                    mv = openai_get_move(board, ai, human);
-                    if (mv < 0 || mv >= 9 || board[mv] != ' ') {
-                        printf("OpenAI failed or returned invalid move, using local AI fallback\n");
-                        mv = get_best_move(board, ai, human);
-                    }
-                } else {
-                    mv = get_best_move(board, ai, human);
+            Uint32 waited = now - aiThinkStartTime;
+            if (aiMove < 0 && aiType == AI_OPENAI && openai_available) {
+                if (!aiRequest) aiRequest = openai_move_start(board, ai, human, OPENAI_DEADLINE_MS);
+                OpenAIStatus st = aiRequest ? openai_move_poll(aiRequest, &aiMove) : OPENAI_FAILED;
+                if (st == OPENAI_FAILED || (st == OPENAI_PENDING && waited >= OPENAI_DEADLINE_MS)) {
+                    printf("OpenAI failed or timed out, using local AI fallback\n");
+                    aiMove = get_best_move(board, ai, human);
                 }
-                if (mv >= 0 && mv < 9 && board[mv] == ' ') {
-                    board[mv] = ai;
-                    place_scale[mv] = 0.0f; place_alpha[mv] = 0;
+                if (aiMove >= 0) {
+                    openai_move_cancel(aiRequest);
+                    aiRequest = NULL;
+                }
+            } else if (aiMove < 0) {
+                aiMove = get_best_move(board, ai, human);
+            }
+            if (aiMove >= 0 && waited > (Uint32)(aiType == AI_OPENAI ? 500 : 300)) {
+                if (board[aiMove] == ' ') {
+                    board[aiMove] = ai;
+                    place_scale[aiMove] = 0.0f; place_alpha[aiMove] = 0;
                 }
                 player_can_move = 1; ai_thinking = false;
+                aiMove = -1;
+                dirty = true;
             }
         }
 
@@ -471,8 +595,18 @@ int main(int argc, char **argv) {
             else if (w == 'O') score.o_wins++;
             else if (w == 'T') score.draws++;
             scene = SCENE_POPUP;
+            dirty = true;
         }
 
+        gui_profiler_mark(prof, GUI_PHASE_AI);
+
+        // Nothing new to show: skip the frame and go back to sleep
+        animating = false;
+        for (int i = 0; i < 9; ++i)
+            if (board[i] != ' ' && (place_scale[i] < 1.0f || place_alpha[i] < 255)) animating = true;
+        if (!dirty && !animating) continue;
+        dirty = false;
+
         // Render
         SDL_SetRenderDrawColor(ren, BG_DARK.r, BG_DARK.g, BG_DARK.b, 255);
         SDL_RenderClear(ren);
@@ -485,7 +619,7 @@ int main(int argc, char **argv) {
             render_ai_select(ren, font, fontSmall, fontTiny, mouseX, mouseY);
         } else {
             // Game header
-            draw_text(ren, font, "TIC TAC TOE", TEXT_PRIMARY, WINDOW_W/2, 50, 1);
+            draw_text(font, "TIC TAC TOE", TEXT_PRIMARY, WINDOW_W/2, 50, 1);
 
             char turnText[128];
             if (gameMode == MODE_TWO_PLAYER) {
@@ -500,22 +634,21 @@ int main(int argc, char **argv) {
                     snprintf(turnText, sizeof(turnText), "Waiting for AI...");
                 }
             }
-            draw_text(ren, fontSmall, turnText, TEXT_SECONDARY, WINDOW_W/2, 100, 1);
+            draw_live_text(fontSmall, turnText, TEXT_SECONDARY, WINDOW_W/2, 100, 1);
 
             // Draw board card
             SDL_Rect boardCard = { 130, 260, 540, 540 };
-            draw_rounded_rect(ren, boardCard, 20, BG_CARD);
+            gui_draw_rounded_rect(shapes, boardCard, 20, BG_CARD);
 
             int gridX = 150, gridY = 280, gridSize = 500;
             int cellW = gridSize / 3;
 
             // Draw grid lines
-            SDL_SetRenderDrawColor(ren, GRID_COLOR.r, GRID_COLOR.g, GRID_COLOR.b, GRID_COLOR.a);
             for (int i = 1; i <= 2; ++i) {
                 int x = gridX + i * cellW;
-                SDL_RenderDrawLine(ren, x, gridY, x, gridY + gridSize);
+                gui_draw_rect(shapes, (SDL_Rect){ x, gridY, 1, gridSize + 1 }, GRID_COLOR);
                 int y = gridY + i * cellW;
-                SDL_RenderDrawLine(ren, gridX, y, gridX + gridSize, y);
+                gui_draw_rect(shapes, (SDL_Rect){ gridX, y, gridSize + 1, 1 }, GRID_COLOR);
             }
 
             // Draw hover cell highlight
@@ -523,7 +656,7 @@ int main(int argc, char **argv) {
                 int cx = hover_cell % 3;
                 int cy = hover_cell / 3;
                 SDL_Rect cellRect = { gridX + cx*cellW + 4, gridY + cy*cellW + 4, cellW - 8, cellW - 8 };
-                draw_rounded_rect(ren, cellRect, 10, CELL_HOVER);
+                gui_draw_rounded_rect(shapes, cellRect, 10, CELL_HOVER);
             }
 
             // Draw X/O
@@ -531,8 +664,8 @@ int main(int argc, char **argv) {
                 int cx = i % 3;
                 int cy = i / 3;
                 SDL_Rect r = { gridX + cx*cellW + 8, gridY + cy*cellW + 8, cellW - 16, cellW - 16 };
-                if (board[i] == 'X') draw_X(ren, r, place_scale[i], place_alpha[i]);
-                else if (board[i] == 'O') draw_O(ren, r, place_scale[i], place_alpha[i]);
+                if (board[i] == 'X') draw_piece('X', r, place_scale[i], place_alpha[i]);
+                else if (board[i] == 'O') draw_piece('O', r, place_scale[i], place_alpha[i]);
             }
 
             // Footer: controls
@@ -543,35 +676,49 @@ int main(int argc, char **argv) {
             bool menuHover = SDL_PointInRect(&mp, &menuBtn);
             SDL_Color restartColor = restartHover ? ACCENT_PRIMARY : BG_CARD;
             SDL_Color menuColor = menuHover ? ACCENT_SECONDARY : BG_CARD;
-            draw_rounded_rect(ren, restartBtn, 8, restartColor);
-            draw_rounded_rect(ren, menuBtn, 8, menuColor);
-            draw_text(ren, fontSmall, "RESTART", TEXT_PRIMARY, restartBtn.x + restartBtn.w/2, restartBtn.y + 8, 1);
-            draw_text(ren, fontSmall, "MENU", TEXT_PRIMARY, menuBtn.x + menuBtn.w/2, menuBtn.y + 8, 1);
+            gui_draw_rounded_rect(shapes, restartBtn, 8, restartColor);
+            gui_draw_rounded_rect(shapes, menuBtn, 8, menuColor);
+            draw_text(fontSmall, "RESTART", TEXT_PRIMARY, restartBtn.x + restartBtn.w/2, restartBtn.y + 8, 1);
+            draw_text(fontSmall, "MENU", TEXT_PRIMARY, menuBtn.x + menuBtn.w/2, menuBtn.y + 8, 1);
 
             // If popup show result overlay
             if (scene == SCENE_POPUP) {
                 SDL_Rect overlay = { 160, 300, 480, 240 };
-                draw_rounded_rect(ren, overlay, 12, BG_CARD);
+                gui_draw_rounded_rect(shapes, overlay, 12, BG_CARD);
                 char resultText[64];
                 if (w == 'X') snprintf(resultText, sizeof(resultText), "X wins!");
                 else if (w == 'O') snprintf(resultText, sizeof(resultText), "O wins!");
                 else snprintf(resultText, sizeof(resultText), "Draw!");
-                draw_text(ren, font, resultText, TEXT_PRIMARY, WINDOW_W/2, overlay.y + 40, 1);
-                draw_text(ren, fontSmall, "Click anywhere to continue", TEXT_SECONDARY, WINDOW_W/2, overlay.y + 90, 1);
+                draw_live_text(font, resultText, TEXT_PRIMARY, WINDOW_W/2, overlay.y + 40, 1);
+                draw_text(fontSmall, "Click anywhere to continue", TEXT_SECONDARY, WINDOW_W/2, overlay.y + 90, 1);
             }
         }
 
+        gui_draw_flush(shapes);
+        gui_profiler_mark(prof, scene_phase(scene));
+        if (showProfiler) {
+            gui_profiler_draw(prof, fontTiny);
+            gui_profiler_mark(prof, GUI_PHASE_OVERLAY);
+        }
         SDL_RenderPresent(ren);
-
-        // small delay to avoid 100% CPU
-        SDL_Delay(8);
+        gui_profiler_mark(prof, GUI_PHASE_PRESENT);
+        gui_profiler_end_frame(prof);
+        gui_text_end_frame(texts);
+        double frameMs = timer_elapsed_ms(frameStart);
+        metrics_observe(frameTime, frameMs / 1000.0);
+        if (frameMs < MIN_FRAME_MS) SDL_Delay((Uint32)(MIN_FRAME_MS - frameMs));
     }
 
     // Cleanup
-    if (openai_available) openai_shutdown();
+    openai_move_cancel(aiRequest);
+    end_speculation(spec, -1);
+    if (openai_available) openai_cleanup();
     if (font) TTF_CloseFont(font);
     if (fontSmall) TTF_CloseFont(fontSmall);
     if (fontTiny) TTF_CloseFont(fontTiny);
+    gui_profiler_destroy(prof);
+    gui_text_destroy(texts);
+    gui_draw_destroy(shapes);
     SDL_DestroyRenderer(ren);
     SDL_DestroyWindow(win);
     TTF_Quit();
@@ -0,0 +1,167 @@
+#include "gui_profiler.h"
+#include "timer.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+/* The frames live in a ring; the overlay works out its statistics from the
+   whole ring each time it is drawn. */
+
+#define KEPT_FRAMES 360         /* also the graph width in pixels */
+#define GRAPH_H 80
+#define GRAPH_MAX_MS 33.3f      /* top of the graph */
+#define BUDGET_MS 16.7f         /* one frame at 60 Hz */
+#define PANEL_X 10
+#define PANEL_Y 10
+#define PAD 10
+
+static const char *const phase_names[GUI_PHASE_COUNT] = {
+    "events", "update", "ai", "welcome", "mode_select", "ai_select", "game", "overlay", "present"
+};
+
+typedef struct {
+    unsigned long number;
+    float total_ms;
+    float phase_ms[GUI_PHASE_COUNT];
+    unsigned draw_calls, rasterized;
+} Frame;
+
+struct GuiProfiler {
+    GuiDraw *shapes;
+    GuiText *texts;
+    uint64_t frame_start, last_mark;
+    unsigned long draw_calls_start, rasterized_start;
+    Frame current;
+    Frame frames[KEPT_FRAMES];
+    int count, next;            /* frames kept, slot for the next one */
+    unsigned long frame_number;
+};
+
+GuiProfiler *gui_profiler_create(GuiDraw *shapes, GuiText *texts) {
+    GuiProfiler *p = calloc(1, sizeof(GuiProfiler));
+    if (!p) return NULL;
+    p->shapes = shapes;
+    p->texts = texts;
+    return p;
+}
+
+static unsigned long draw_calls(const GuiProfiler *p) {
+    return gui_draw_calls(p->shapes) + gui_text_draw_calls(p->texts);
+}
+
+void gui_profiler_begin_frame(GuiProfiler *p) {
+    p->frame_start = p->last_mark = timer_now_ns();
+    p->draw_calls_start = draw_calls(p);
+    p->rasterized_start = gui_text_rasterized(p->texts);
+    for (int i = 0; i < GUI_PHASE_COUNT; ++i) p->current.phase_ms[i] = 0.0f;
+}
+
+void gui_profiler_mark(GuiProfiler *p, GuiPhase phase) {
+    uint64_t now = timer_now_ns();
+    p->current.phase_ms[phase] += (float)((now - p->last_mark) / 1e6);
+    p->last_mark = now;
+}
+
+void gui_profiler_end_frame(GuiProfiler *p) {
+    Frame *f = &p->current;
+    f->number = p->frame_number++;
+    f->total_ms = (float)timer_elapsed_ms(p->frame_start);
+    f->draw_calls = (unsigned)(draw_calls(p) - p->draw_calls_start);
+    f->rasterized = (unsigned)(gui_text_rasterized(p->texts) - p->rasterized_start);
+    p->frames[p->next] = *f;
+    p->next = (p->next + 1) % KEPT_FRAMES;
+    if (p->count < KEPT_FRAMES) p->count++;
+}
+
+/* The i-th kept frame, oldest first */
+static const Frame *kept(const GuiProfiler *p, int i) {
+    return &p->frames[(p->next - p->count + i + KEPT_FRAMES) % KEPT_FRAMES];
+}
+
+static int cmp_float(const void *a, const void *b) {
+    float x = *(const float *)a, y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+static float percentile(const float *sorted, int n, float q) {
+    return sorted[(int)(q * (n - 1) + 0.5f)];
+}
+
+static void line(GuiProfiler *p, TTF_Font *font, const char *text, int x, int y) {
+    static const SDL_Color color = { 226, 232, 240, 255 };
+    gui_text_draw_live(p->texts, font, text, color, x, y, 0);
+}
+
+void gui_profiler_draw(GuiProfiler *p, TTF_Font *font) {
+    static const SDL_Color panel = { 2, 6, 23, 215 };
+    static const SDL_Color ok = { 74, 222, 128, 255 }, slow = { 250, 204, 21, 255 }, hitch = { 248, 113, 113, 255 };
+    static const SDL_Color budget = { 148, 163, 184, 160 };
+    int skip = font ? TTF_FontLineSkip(font) : 0;
+    SDL_Rect bg = { PANEL_X, PANEL_Y, KEPT_FRAMES + 2 * PAD, GRAPH_H + 3 * PAD + (GUI_PHASE_COUNT + 3) * skip };
+    gui_draw_rect(p->shapes, bg, panel);
+
+    /* One bar per kept frame, newest on the right */
+    int gx = PANEL_X + PAD, gy = PANEL_Y + PAD;
+    for (int i = 0; i < p->count; ++i) {
+        float ms = kept(p, i)->total_ms;
+        int h = (int)(GRAPH_H * (ms < GRAPH_MAX_MS ? ms : GRAPH_MAX_MS) / GRAPH_MAX_MS);
+        SDL_Rect bar = { gx + KEPT_FRAMES - p->count + i, gy + GRAPH_H - h, 1, h > 0 ? h : 1 };
+        gui_draw_rect(p->shapes, bar, ms <= BUDGET_MS ? ok : ms <= GRAPH_MAX_MS ? slow : hitch);
+    }
+    SDL_Rect budget_line = { gx, gy + GRAPH_H - (int)(GRAPH_H * BUDGET_MS / GRAPH_MAX_MS), KEPT_FRAMES, 1 };
+    gui_draw_rect(p->shapes, budget_line, budget);
+    gui_draw_flush(p->shapes);
+    if (!font || p->count == 0) return;
+
+    float totals[KEPT_FRAMES], avg[GUI_PHASE_COUNT] = { 0 }, max[GUI_PHASE_COUNT] = { 0 };
+    for (int i = 0; i < p->count; ++i) {
+        const Frame *f = kept(p, i);
+        totals[i] = f->total_ms;
+        for (int k = 0; k < GUI_PHASE_COUNT; ++k) {
+            avg[k] += f->phase_ms[k] / p->count;
+            if (f->phase_ms[k] > max[k]) max[k] = f->phase_ms[k];
+        }
+    }
+    qsort(totals, (size_t)p->count, sizeof(float), cmp_float);
+
+    char text[128];
+    int x = gx, y = gy + GRAPH_H + PAD;
+    snprintf(text, sizeof(text), "frame ms  p50 %.2f  p95 %.2f  p99 %.2f  max %.2f",
+             percentile(totals, p->count, 0.50f), percentile(totals, p->count, 0.95f),
+             percentile(totals, p->count, 0.99f), totals[p->count - 1]);
+    line(p, font, text, x, y);
+    y += skip;
+    const Frame *last = kept(p, p->count - 1);
+    snprintf(text, sizeof(text), "last frame  %u draw calls  %u rasterized", last->draw_calls, last->rasterized);
+    line(p, font, text, x, y);
+    y += skip;
+    line(p, font, "phase", x, y);
+    line(p, font, "avg ms", x + 140, y);
+    line(p, font, "max ms", x + 230, y);
+    for (int k = 0; k < GUI_PHASE_COUNT; ++k) {
+        y += skip;
+        line(p, font, phase_names[k], x, y);
+        snprintf(text, sizeof(text), "%.3f", avg[k]);
+        line(p, font, text, x + 140, y);
+        snprintf(text, sizeof(text), "%.3f", max[k]);
+        line(p, font, text, x + 230, y);
+    }
+}
+
+int gui_profiler_write_csv(const GuiProfiler *p, const char *path) {
+    FILE *f = fopen(path, "w");
+    if (!f) return -1;
+    fprintf(f, "frame,total_ms");
+    for (int k = 0; k < GUI_PHASE_COUNT; ++k) fprintf(f, ",%s_ms", phase_names[k]);
+    fprintf(f, ",draw_calls,rasterized\n");
+    for (int i = 0; i < p->count; ++i) {
+        const Frame *fr = kept(p, i);
+        fprintf(f, "%lu,%.4f", fr->number, fr->total_ms);
+        for (int k = 0; k < GUI_PHASE_COUNT; ++k) fprintf(f, ",%.4f", fr->phase_ms[k]);
+        fprintf(f, ",%u,%u\n", fr->draw_calls, fr->rasterized);
+    }
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+void gui_profiler_destroy(GuiProfiler *p) {
+    free(p);
+}
@@ -0,0 +1,51 @@
+#ifndef GUI_PROFILER_H
+#define GUI_PROFILER_H
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include "gui_draw.h"
+#include "gui_text.h"
+
+/* Frame profiler for the SDL GUIs. Each frame is split into phases: the
+   loop calls gui_profiler_begin_frame when the frame starts and
+   gui_profiler_mark after each phase, which charges the time since the
+   previous mark to that phase. The last few hundred frames are kept, with
+   the draw calls and text rasterizations made in each.
+
+   SDL queues render commands until SDL_RenderPresent, so the scene phases
+   measure building the frame and the GPU side shows up under present. */
+
+typedef enum {
+    GUI_PHASE_EVENTS,       /* event handling */
+    GUI_PHASE_UPDATE,       /* animations */
+    GUI_PHASE_AI,           /* the AI's turn, pondering, OpenAI polling */
+    GUI_PHASE_WELCOME,      /* render_welcome */
+    GUI_PHASE_MODE_SELECT,  /* render_mode_select */
+    GUI_PHASE_AI_SELECT,    /* render_ai_select */
+    GUI_PHASE_GAME,         /* the board and popup */
+    GUI_PHASE_OVERLAY,      /* gui_profiler_draw itself */
+    GUI_PHASE_PRESENT,      /* SDL_RenderPresent */
+    GUI_PHASE_COUNT
+} GuiPhase;
+
+typedef struct GuiProfiler GuiProfiler;
+
+/* A profiler counting the draw calls of `shapes` and `texts`; NULL if out of memory */
+GuiProfiler *gui_profiler_create(GuiDraw *shapes, GuiText *texts);
+
+void gui_profiler_begin_frame(GuiProfiler *p);
+void gui_profiler_mark(GuiProfiler *p, GuiPhase phase);
+
+/* Records the frame begun by gui_profiler_begin_frame */
+void gui_profiler_end_frame(GuiProfiler *p);
+
+/* Draws the frame-time graph, percentiles and per-phase times in a panel
+   at the top left; `font` should be small */
+void gui_profiler_draw(GuiProfiler *p, TTF_Font *font);
+
+/* Writes the kept frames, oldest first, as CSV; 0 on success, -1 on error */
+int gui_profiler_write_csv(const GuiProfiler *p, const char *path);
+
+void gui_profiler_destroy(GuiProfiler *p);
+
+#endif /* GUI_PROFILER_H */
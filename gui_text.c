@@ -0,0 +1,282 @@
+#include "gui_text.h"
+#include "metrics.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if !SDL_VERSION_ATLEAST(2, 0, 18)
+#error "gui_text.c needs SDL 2.0.18 or newer (SDL_RenderGeometry)"
+#endif
+
+/* Whole strings live in a small fixed table, evicted least recently used
+   first or after IDLE_FRAMES without a draw. Each atlas is one texture of
+   white glyphs packed in rows; the vertex colors tint it, so every color of
+   a font shares it. */
+
+#define CACHE_SIZE 64
+#define MAX_CACHED_LEN 128      /* longer strings are rendered every time */
+#define IDLE_FRAMES 600
+#define MAX_ATLASES 4           /* fonts */
+#define FIRST_GLYPH 32
+#define LAST_GLYPH 126
+#define GLYPH_COUNT (LAST_GLYPH - FIRST_GLYPH + 1)
+#define ATLAS_W 512
+#define MAX_LIVE_GLYPHS 128
+
+#ifdef SDL_TTF_VERSION_ATLEAST
+#if SDL_TTF_VERSION_ATLEAST(2, 0, 14)
+#define HAVE_KERNING 1
+#endif
+#endif
+
+typedef struct {
+    SDL_Texture *tex;       /* NULL if the slot is free */
+    TTF_Font *font;
+    SDL_Color color;
+    Uint32 hash;
+    char text[MAX_CACHED_LEN];
+    int w, h;
+    Uint32 last_used;       /* frame number */
+} CachedString;
+
+typedef struct {
+    SDL_Rect src;           /* in the atlas; empty for blank glyphs */
+    int advance;
+} Glyph;
+
+typedef struct {
+    TTF_Font *font;         /* NULL if the slot is free */
+    SDL_Texture *tex;       /* NULL if the atlas could not be built */
+    Glyph glyph[GLYPH_COUNT];
+} Atlas;
+
+struct GuiText {
+    SDL_Renderer *ren;
+    Uint32 frame;
+    unsigned long draw_calls, rasterized;
+    CachedString strings[CACHE_SIZE];
+    Atlas atlases[MAX_ATLASES];
+};
+
+GuiText *gui_text_create(SDL_Renderer *ren) {
+    GuiText *t = calloc(1, sizeof(GuiText));
+    if (t) t->ren = ren;
+    return t;
+}
+
+static Uint32 text_hash(const char *text) {
+    Uint32 h = 2166136261u;     /* FNV-1a */
+    for (; *text; ++text) h = (h ^ (unsigned char)*text) * 16777619u;
+    return h;
+}
+
+static SDL_Texture *rasterize(GuiText *t, TTF_Font *font, const char *text, SDL_Color color, int *w, int *h) {
+    SDL_Surface *surf = TTF_RenderUTF8_Blended(font, text, color);
+    if (!surf) return NULL;
+    SDL_Texture *tex = SDL_CreateTextureFromSurface(t->ren, surf);
+    *w = surf->w;
+    *h = surf->h;
+    SDL_FreeSurface(surf);
+    t->rasterized++;
+    metrics_add(metrics_counter("gui_text_rasterized_total", "Strings rasterized by the GUI"), 1);
+    return tex;
+}
+
+static void copy_texture(GuiText *t, SDL_Texture *tex, int w, int h, int x, int y, int center) {
+    SDL_Rect dst = { center ? x - w / 2 : x, y, w, h };
+    SDL_RenderCopy(t->ren, tex, NULL, &dst);
+    t->draw_calls++;
+}
+
+static int same_color(SDL_Color a, SDL_Color b) {
+    return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+void gui_text_draw(GuiText *t, TTF_Font *font, const char *text, SDL_Color color, int x, int y, int center) {
+    if (!font || !text || !*text) return;
+    int w, h;
+    if (strlen(text) >= MAX_CACHED_LEN) {
+        SDL_Texture *tex = rasterize(t, font, text, color, &w, &h);
+        if (tex) {
+            copy_texture(t, tex, w, h, x, y, center);
+            SDL_DestroyTexture(tex);
+        }
+        return;
+    }
+
+    Uint32 hash = text_hash(text);
+    CachedString *victim = &t->strings[0];
+    for (int i = 0; i < CACHE_SIZE; ++i) {
+        CachedString *s = &t->strings[i];
+        if (s->tex && s->hash == hash && s->font == font && same_color(s->color, color) &&
+            strcmp(s->text, text) == 0) {
+            s->last_used = t->frame;
+            copy_texture(t, s->tex, s->w, s->h, x, y, center);
+            return;
+        }
+        /* a free slot, else the least recently drawn string */
+        if (victim->tex && (!s->tex || s->last_used < victim->last_used)) victim = s;
+    }
+
+    if (victim->tex) SDL_DestroyTexture(victim->tex);
+    victim->tex = rasterize(t, font, text, color, &w, &h);
+    if (!victim->tex) return;
+    victim->font = font;
+    victim->color = color;
+    victim->hash = hash;
+    strcpy(victim->text, text);
+    victim->w = w;
+    victim->h = h;
+    victim->last_used = t->frame;
+    copy_texture(t, victim->tex, w, h, x, y, center);
+}
+
+/* Renders the printable ASCII glyphs of `a->font` and packs them into one texture */
+static void build_atlas(GuiText *t, Atlas *a) {
+    static const SDL_Color white = { 255, 255, 255, 255 };
+    SDL_Surface *glyphs[GLYPH_COUNT];
+    int x = 0, y = 0, row_h = 0;
+    for (int i = 0; i < GLYPH_COUNT; ++i) {
+        Uint16 ch = (Uint16)(FIRST_GLYPH + i);
+        int minx, maxx, miny, maxy, advance = 0;
+        TTF_GlyphMetrics(a->font, ch, &minx, &maxx, &miny, &maxy, &advance);
+        a->glyph[i].advance = advance;
+        glyphs[i] = ch == ' ' ? NULL : TTF_RenderGlyph_Blended(a->font, ch, white);
+        SDL_Rect r = { 0, 0, 0, 0 };
+        if (glyphs[i]) {
+            if (x + glyphs[i]->w > ATLAS_W) {
+                x = 0;
+                y += row_h + 1;
+                row_h = 0;
+            }
+            r = (SDL_Rect){ x, y, glyphs[i]->w, glyphs[i]->h };
+            x += r.w + 1;   /* a transparent column keeps filtering from bleeding */
+            if (r.h > row_h) row_h = r.h;
+        }
+        a->glyph[i].src = r;
+    }
+
+    SDL_Surface *sheet = SDL_CreateRGBSurfaceWithFormat(0, ATLAS_W, y + row_h, 32, SDL_PIXELFORMAT_RGBA32);
+    if (sheet) {
+        SDL_FillRect(sheet, NULL, 0);
+        for (int i = 0; i < GLYPH_COUNT; ++i) {
+            if (!glyphs[i]) continue;
+            SDL_SetSurfaceBlendMode(glyphs[i], SDL_BLENDMODE_NONE);     /* copy alpha as is */
+            SDL_Rect dst = a->glyph[i].src;
+            SDL_BlitSurface(glyphs[i], NULL, sheet, &dst);
+        }
+        a->tex = SDL_CreateTextureFromSurface(t->ren, sheet);
+        if (a->tex) SDL_SetTextureBlendMode(a->tex, SDL_BLENDMODE_BLEND);
+        SDL_FreeSurface(sheet);
+        metrics_add(metrics_counter("gui_text_atlases_total", "Glyph atlases built by the GUI"), 1);
+    }
+    for (int i = 0; i < GLYPH_COUNT; ++i)
+        if (glyphs[i]) SDL_FreeSurface(glyphs[i]);
+}
+
+/* The atlas of `font`, built on first use; NULL if there is none */
+static Atlas *atlas_for(GuiText *t, TTF_Font *font) {
+    Atlas *slot = NULL;
+    for (int i = 0; i < MAX_ATLASES; ++i) {
+        Atlas *a = &t->atlases[i];
+        if (a->font == font) return a->tex ? a : NULL;
+        if (!a->font && !slot) slot = a;
+    }
+    if (!slot) return NULL;
+    slot->font = font;
+    build_atlas(t, slot);
+    return slot->tex ? slot : NULL;
+}
+
+static int kerning(TTF_Font *font, int prev, int ch) {
+#ifdef HAVE_KERNING
+    return prev ? TTF_GetFontKerningSizeGlyphs(font, (Uint16)prev, (Uint16)ch) : 0;
+#else
+    (void)font, (void)prev, (void)ch;
+    return 0;
+#endif
+}
+
+void gui_text_draw_live(GuiText *t, TTF_Font *font, const char *text, SDL_Color color, int x, int y, int center) {
+    if (!font || !text || !*text) return;
+    size_t len = strlen(text);
+    int printable = len <= MAX_LIVE_GLYPHS;
+    for (const char *p = text; printable && *p; ++p) printable = *p >= FIRST_GLYPH && *p <= LAST_GLYPH;
+    Atlas *a = printable ? atlas_for(t, font) : NULL;
+    if (!a) {
+        gui_text_draw(t, font, text, color, x, y, center);
+        return;
+    }
+
+    if (center) {
+        int width = 0;
+        for (size_t i = 0; i < len; ++i)
+            width += kerning(font, i ? text[i - 1] : 0, text[i]) + a->glyph[text[i] - FIRST_GLYPH].advance;
+        x -= width / 2;
+    }
+
+    /* One textured quad per glyph, all in one draw call */
+    SDL_Vertex v[4 * MAX_LIVE_GLYPHS];
+    int idx[6 * MAX_LIVE_GLYPHS];
+    int tex_w, tex_h, quads = 0;
+    SDL_QueryTexture(a->tex, NULL, NULL, &tex_w, &tex_h);
+    for (size_t i = 0; i < len; ++i) {
+        const Glyph *g = &a->glyph[text[i] - FIRST_GLYPH];
+        x += kerning(font, i ? text[i - 1] : 0, text[i]);
+        if (g->src.w > 0) {
+            float x0 = (float)x, y0 = (float)y, x1 = x0 + g->src.w, y1 = y0 + g->src.h;
+            float u0 = (float)g->src.x / tex_w, v0 = (float)g->src.y / tex_h;
+            float u1 = (float)(g->src.x + g->src.w) / tex_w, v1 = (float)(g->src.y + g->src.h) / tex_h;
+            SDL_Vertex *q = &v[4 * quads];
+            q[0] = (SDL_Vertex){ { x0, y0 }, color, { u0, v0 } };
+            q[1] = (SDL_Vertex){ { x1, y0 }, color, { u1, v0 } };
+            q[2] = (SDL_Vertex){ { x1, y1 }, color, { u1, v1 } };
+            q[3] = (SDL_Vertex){ { x0, y1 }, color, { u0, v1 } };
+            int *k = &idx[6 * quads];
+            k[0] = 4 * quads; k[1] = 4 * quads + 1; k[2] = 4 * quads + 2;
+            k[3] = 4 * quads; k[4] = 4 * quads + 2; k[5] = 4 * quads + 3;
+            ++quads;
+        }
+        x += g->advance;
+    }
+    if (quads) {
+        SDL_RenderGeometry(t->ren, a->tex, v, 4 * quads, idx, 6 * quads);
+        t->draw_calls++;
+    }
+}
+
+unsigned long gui_text_draw_calls(const GuiText *t) {
+    return t->draw_calls;
+}
+
+unsigned long gui_text_rasterized(const GuiText *t) {
+    return t->rasterized;
+}
+
+void gui_text_end_frame(GuiText *t) {
+    t->frame++;
+    for (int i = 0; i < CACHE_SIZE; ++i) {
+        CachedString *s = &t->strings[i];
+        if (s->tex && t->frame - s->last_used > IDLE_FRAMES) {
+            SDL_DestroyTexture(s->tex);
+            s->tex = NULL;
+        }
+    }
+}
+
+void gui_text_reset(GuiText *t) {
+    for (int i = 0; i < CACHE_SIZE; ++i) {
+        if (t->strings[i].tex) SDL_DestroyTexture(t->strings[i].tex);
+        t->strings[i].tex = NULL;
+    }
+    for (int i = 0; i < MAX_ATLASES; ++i) {
+        if (t->atlases[i].tex) SDL_DestroyTexture(t->atlases[i].tex);
+        t->atlases[i].tex = NULL;
+        t->atlases[i].font = NULL;
+    }
+}
+
+void gui_text_destroy(GuiText *t) {
+    if (!t) return;
+    gui_text_reset(t);
+    free(t);
+}
@@ -0,0 +1,46 @@
+#ifndef GUI_TEXT_H
+#define GUI_TEXT_H
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+
+/* Text drawing for the SDL GUIs without rasterizing every string every frame.
+
+   gui_text_draw keeps each string it has drawn as a texture, keyed by font,
+   color and text, so a static label is rendered once and then costs one
+   texture copy. Strings not drawn for a while are dropped, which is how an
+   old score or status line leaves the cache.
+
+   gui_text_draw_live is for strings that change often: it assembles them
+   from a per-font atlas of the printable ASCII glyphs, in one draw call per
+   string, and never rasterizes after the atlas is built. Needs SDL 2.0.18
+   or newer. */
+
+typedef struct GuiText GuiText;
+
+/* Text drawn with `ren`; NULL if out of memory */
+GuiText *gui_text_create(SDL_Renderer *ren);
+
+/* Draws `text` at (x, y), or centered on x if `center`; from the cache when
+   it was drawn before */
+void gui_text_draw(GuiText *t, TTF_Font *font, const char *text, SDL_Color color, int x, int y, int center);
+
+/* Like gui_text_draw, but built from glyphs, for strings that change from
+   frame to frame. Text outside printable ASCII goes through gui_text_draw. */
+void gui_text_draw_live(GuiText *t, TTF_Font *font, const char *text, SDL_Color color, int x, int y, int center);
+
+/* SDL draw calls made so far, and strings rasterized so far (atlases not included) */
+unsigned long gui_text_draw_calls(const GuiText *t);
+unsigned long gui_text_rasterized(const GuiText *t);
+
+/* Call once per frame: drops strings not drawn in the last few hundred frames */
+void gui_text_end_frame(GuiText *t);
+
+/* Drops every texture, e.g. after SDL_RENDER_TARGETS_RESET or
+   SDL_RENDER_DEVICE_RESET; they are rebuilt on demand */
+void gui_text_reset(GuiText *t);
+
+/* Frees `t` (may be NULL) and its textures; call before destroying the renderer */
+void gui_text_destroy(GuiText *t);
+
+#endif /* GUI_TEXT_H */
@@ -0,0 +1,336 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200112L
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "llm_cache.h"
+#include "game.h"
+#include "metrics.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* In memory: a fixed pool of entries, chained into hash buckets and into
+   a most-recently-used list, all by index.
+
+   On disk: a 16-byte header followed by 16-byte records appended as
+   answers arrive; when a key repeats, the later record wins. The file is
+   memory-mapped once at open and rewritten without dead records when
+   they outnumber the live ones. */
+
+#define FILE_MAGIC 0x434D4C4Cu     /* "LLMC" */
+#define FILE_VERSION 1u
+#define NONE UINT32_MAX
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t reserved;
+} FileHeader;
+
+typedef struct {
+    uint32_t key;           /* canonical mover << 9 | opponent */
+    uint32_t model;         /* hash of the model name */
+    uint32_t stored_at;     /* seconds since the epoch */
+    uint8_t move;           /* in canonical orientation; 0xFF clears the entry */
+    uint8_t pad[3];
+} Record;
+
+typedef struct {
+    Record rec;
+    uint32_t prev, next;    /* recency list */
+    uint32_t chain;         /* next entry in the same bucket */
+} Entry;
+
+struct LlmCache {
+    Entry *entries;
+    uint32_t *buckets;
+    uint32_t capacity, bucket_mask, used;
+    uint32_t head, tail;    /* most and least recently used */
+    uint32_t free_list;     /* through `next` */
+    long ttl;
+    FILE *log;
+    char *path;
+    LlmCacheStats stats;
+    pthread_mutex_t lock;
+};
+
+static uint32_t model_hash(const char *model) {
+    uint32_t h = 2166136261u;   /* FNV-1a */
+    for (; *model; ++model) h = (h ^ (unsigned char)*model) * 16777619u;
+    return h;
+}
+
+/* Canonical key for `player` to move; `*t` receives the transform used */
+static uint32_t position_key(const char board[9], char player, int *t) {
+    Bitboard me = board_to_bits(board, player);
+    Bitboard opp = board_to_bits(board, player == 'X' ? 'O' : 'X');
+    *t = bits_canonical(&me, &opp);
+    return ((uint32_t)me << 9) | opp;
+}
+
+static uint32_t bucket_of(const LlmCache *c, uint32_t key, uint32_t model) {
+    return ((key * 2654435761u) ^ model) & c->bucket_mask;
+}
+
+static uint32_t find(const LlmCache *c, uint32_t key, uint32_t model) {
+    for (uint32_t i = c->buckets[bucket_of(c, key, model)]; i != NONE; i = c->entries[i].chain)
+        if (c->entries[i].rec.key == key && c->entries[i].rec.model == model) return i;
+    return NONE;
+}
+
+static void list_unlink(LlmCache *c, uint32_t i) {
+    Entry *e = &c->entries[i];
+    if (e->prev != NONE) c->entries[e->prev].next = e->next; else c->head = e->next;
+    if (e->next != NONE) c->entries[e->next].prev = e->prev; else c->tail = e->prev;
+}
+
+static void list_push_front(LlmCache *c, uint32_t i) {
+    Entry *e = &c->entries[i];
+    e->prev = NONE;
+    e->next = c->head;
+    if (c->head != NONE) c->entries[c->head].prev = i;
+    c->head = i;
+    if (c->tail == NONE) c->tail = i;
+}
+
+static void remove_entry(LlmCache *c, uint32_t i) {
+    Entry *e = &c->entries[i];
+    uint32_t *link = &c->buckets[bucket_of(c, e->rec.key, e->rec.model)];
+    while (*link != i) link = &c->entries[*link].chain;
+    *link = e->chain;
+    list_unlink(c, i);
+    e->next = c->free_list;
+    c->free_list = i;
+    c->used--;
+}
+
+/* Inserts or replaces the entry for rec's key, evicting the least
+   recently used one when full */
+static void insert(LlmCache *c, const Record *rec) {
+    uint32_t i = find(c, rec->key, rec->model);
+    if (i != NONE) {
+        c->entries[i].rec = *rec;
+        list_unlink(c, i);
+        list_push_front(c, i);
+        return;
+    }
+    if (c->free_list == NONE) {
+        remove_entry(c, c->tail);
+        c->stats.evictions++;
+    }
+    i = c->free_list;
+    c->free_list = c->entries[i].next;
+    Entry *e = &c->entries[i];
+    e->rec = *rec;
+    uint32_t b = bucket_of(c, rec->key, rec->model);
+    e->chain = c->buckets[b];
+    c->buckets[b] = i;
+    list_push_front(c, i);
+    c->used++;
+}
+
+static void reset_memory(LlmCache *c) {
+    for (uint32_t b = 0; b <= c->bucket_mask; ++b) c->buckets[b] = NONE;
+    for (uint32_t i = 0; i < c->capacity; ++i) c->entries[i].next = (i + 1 < c->capacity) ? i + 1 : NONE;
+    c->free_list = 0;
+    c->head = c->tail = NONE;
+    c->used = 0;
+}
+
+static int expired(const LlmCache *c, const Record *rec, uint32_t now) {
+    return c->ttl > 0 && now - rec->stored_at > (uint32_t)c->ttl;
+}
+
+/* Loads the records of a file image; returns how many there were, or -1
+   if it is not a cache file */
+static long load_image(LlmCache *c, const unsigned char *data, size_t size) {
+    FileHeader h;
+    if (size < sizeof(h)) return -1;
+    memcpy(&h, data, sizeof(h));
+    if (h.magic != FILE_MAGIC || h.version != FILE_VERSION || h.record_size != sizeof(Record)) return -1;
+    uint32_t now = (uint32_t)time(NULL);
+    long count = (long)((size - sizeof(h)) / sizeof(Record));
+    for (long k = 0; k < count; ++k) {
+        Record rec;
+        memcpy(&rec, data + sizeof(h) + (size_t)k * sizeof(Record), sizeof(rec));
+        if (rec.move == 0xFF) {
+            uint32_t i = find(c, rec.key, rec.model);
+            if (i != NONE) remove_entry(c, i);
+        } else if (rec.move < 9 && !expired(c, &rec, now)) {
+            insert(c, &rec);
+        }
+    }
+    return count;
+}
+
+/* Maps the file (or reads it where mmap is unavailable) and loads it */
+static long load_file(LlmCache *c, const char *path) {
+    long records = -1;
+#ifndef _WIN32
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            records = load_image(c, map, (size_t)st.st_size);
+            munmap(map, (size_t)st.st_size);
+        }
+    }
+    close(fd);
+#else
+    FILE *f = fopen(path, "rb");
+    if (!f) return -1;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    unsigned char *buf = size > 0 ? malloc((size_t)size) : NULL;
+    if (buf && fread(buf, 1, (size_t)size, f) == (size_t)size) records = load_image(c, buf, (size_t)size);
+    free(buf);
+    fclose(f);
+#endif
+    return records;
+}
+
+/* Writes the live entries, oldest first, to a fresh file and opens it for appending */
+static void rewrite_file(LlmCache *c) {
+    if (c->log) fclose(c->log);
+    c->log = NULL;
+    size_t len = strlen(c->path);
+    char *tmp = malloc(len + 5);
+    if (!tmp) return;
+    memcpy(tmp, c->path, len);
+    memcpy(tmp + len, ".tmp", 5);
+
+    FILE *f = fopen(tmp, "wb");
+    if (f) {
+        FileHeader h = { FILE_MAGIC, FILE_VERSION, sizeof(Record), 0 };
+        int ok = fwrite(&h, sizeof(h), 1, f) == 1;
+        for (uint32_t i = c->tail; ok && i != NONE; i = c->entries[i].prev)
+            ok = fwrite(&c->entries[i].rec, sizeof(Record), 1, f) == 1;
+        ok = (fclose(f) == 0) && ok;
+        if (ok) {
+            remove(c->path);    /* rename does not replace files on Windows */
+            ok = rename(tmp, c->path) == 0;
+        }
+        if (!ok) remove(tmp);
+    }
+    free(tmp);
+    c->log = fopen(c->path, "ab");
+}
+
+LlmCache *llm_cache_open(const char *path, size_t capacity, long ttl_seconds) {
+    if (capacity < 1) capacity = 1;
+    LlmCache *c = calloc(1, sizeof(LlmCache));
+    if (!c) return NULL;
+    c->capacity = (uint32_t)capacity;
+    uint32_t buckets = 1;
+    while (buckets < c->capacity) buckets <<= 1;
+    c->bucket_mask = buckets - 1;
+    c->entries = malloc(capacity * sizeof(Entry));
+    c->buckets = malloc(buckets * sizeof(uint32_t));
+    if (!c->entries || !c->buckets) {
+        free(c->entries);
+        free(c->buckets);
+        free(c);
+        return NULL;
+    }
+    c->ttl = ttl_seconds;
+    pthread_mutex_init(&c->lock, NULL);
+    reset_memory(c);
+
+    if (path) {
+        c->path = malloc(strlen(path) + 1);
+        if (c->path) {
+            strcpy(c->path, path);
+            long records = load_file(c, path);
+            if (records < 0 || (uint32_t)records > 2 * c->used + 64) rewrite_file(c);
+            else c->log = fopen(path, "ab");
+        }
+    }
+    c->stats.entries = c->used;
+    return c;
+}
+
+static void append(LlmCache *c, const Record *rec) {
+    if (!c->log) return;
+    if (fwrite(rec, sizeof(*rec), 1, c->log) == 1) fflush(c->log);
+}
+
+int llm_cache_get(LlmCache *c, const char board[9], char player, const char *model, int *move) {
+    int t;
+    uint32_t key = position_key(board, player, &t);
+    uint32_t hash = model_hash(model);
+    int hit = 0;
+
+    pthread_mutex_lock(&c->lock);
+    uint32_t i = find(c, key, hash);
+    if (i != NONE && expired(c, &c->entries[i].rec, (uint32_t)time(NULL))) {
+        remove_entry(c, i);
+        c->stats.expired++;
+        i = NONE;
+    }
+    if (i != NONE) {
+        *move = sym_perm[sym_inverse[t]][c->entries[i].rec.move];
+        list_unlink(c, i);
+        list_push_front(c, i);
+        c->stats.hits++;
+        hit = 1;
+    } else {
+        c->stats.misses++;
+    }
+    c->stats.entries = c->used;
+    pthread_mutex_unlock(&c->lock);
+
+    if (hit) metrics_add(metrics_counter("llm_cache_hits_total", "Model answers served from the cache"), 1);
+    else metrics_add(metrics_counter("llm_cache_misses_total", "Model answers not in the cache"), 1);
+    return hit;
+}
+
+void llm_cache_put(LlmCache *c, const char board[9], char player, const char *model, int move) {
+    if (move < 0 || move > 8) return;
+    int t;
+    Record rec;
+    memset(&rec, 0, sizeof(rec));
+    rec.key = position_key(board, player, &t);
+    rec.model = model_hash(model);
+    rec.stored_at = (uint32_t)time(NULL);
+    rec.move = (uint8_t)sym_perm[t][move];
+
+    pthread_mutex_lock(&c->lock);
+    insert(c, &rec);
+    append(c, &rec);
+    c->stats.entries = c->used;
+    pthread_mutex_unlock(&c->lock);
+}
+
+void llm_cache_clear(LlmCache *c) {
+    pthread_mutex_lock(&c->lock);
+    reset_memory(c);
+    c->stats.entries = 0;
+    if (c->path) rewrite_file(c);
+    pthread_mutex_unlock(&c->lock);
+}
+
+void llm_cache_stats(LlmCache *c, LlmCacheStats *stats) {
+    pthread_mutex_lock(&c->lock);
+    *stats = c->stats;
+    pthread_mutex_unlock(&c->lock);
+}
+
+void llm_cache_close(LlmCache *c) {
+    if (!c) return;
+    if (c->log) fclose(c->log);
+    pthread_mutex_destroy(&c->lock);
+    free(c->path);
+    free(c->entries);
+    free(c->buckets);
+    free(c);
+}
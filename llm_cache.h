@@ -0,0 +1,42 @@
+#ifndef LLM_CACHE_H
+#define LLM_CACHE_H
+
+#include <stddef.h>
+
+/* Cache of model move answers. Positions are keyed by their canonical form
+   (the 8 symmetries folded together, stones named by mover and opponent
+   rather than X and O) plus the model name, so an answer is reused for
+   every equivalent position but never across models. */
+
+typedef struct LlmCache LlmCache;
+
+typedef struct {
+    unsigned long hits;
+    unsigned long misses;
+    unsigned long expired;      /* misses on entries older than the TTL */
+    unsigned long evictions;    /* least recently used entries dropped for space */
+    size_t entries;
+} LlmCacheStats;
+
+/* Opens a cache holding at most `capacity` answers, each valid for `ttl_seconds`
+   (<= 0 for no limit). With a `path`, answers stored there earlier are loaded and new
+   ones are appended to it; NULL keeps the cache in memory only. Returns NULL if memory
+   runs out; an unreadable or unwritable file only disables persistence. */
+LlmCache *llm_cache_open(const char *path, size_t capacity, long ttl_seconds);
+
+/* Looks up the answer for `player` to move on `board` (X, O and ' ') under `model`.
+   Returns 1 and stores the move in `*move` on a hit, 0 on a miss. */
+int llm_cache_get(LlmCache *c, const char board[9], char player, const char *model, int *move);
+
+/* Remembers `move` as the answer for `player` on `board` under `model` */
+void llm_cache_put(LlmCache *c, const char board[9], char player, const char *model, int move);
+
+/* Drops every answer, in memory and on disk */
+void llm_cache_clear(LlmCache *c);
+
+void llm_cache_stats(LlmCache *c, LlmCacheStats *stats);
+
+/* Frees the cache; stored answers stay on disk */
+void llm_cache_close(LlmCache *c);
+
+#endif /* LLM_CACHE_H */
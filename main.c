@@ -3,8 +3,59 @@
 #include <string.h>
 #include "game.h"
 #include "ai.h"
+#include "batch.h"
+#include "metrics.h"
+#include "ponder.h"
+
+static int usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [--stats | --stats=json] [--no-ponder] [--batch [FILE] [--threads N]]\n", prog);
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    /* --stats prints the cost of each AI move and all metrics at exit;
+       --stats=json dumps them as JSON instead.
+       --no-ponder leaves the AI idle during the human's turn;
+       --batch analyzes positions from FILE (or stdin) without playing */
+    int show_stats = 0, batch = 0, threads = 0, use_ponder = 1;
+    MetricsFormat stats_format = METRICS_PROMETHEUS;
+    const char *batch_file = NULL;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--stats") == 0 || strcmp(argv[i], "--stats=json") == 0) {
+            show_stats = 1;
+            if (argv[i][7]) stats_format = METRICS_JSON;
+        } else if (strcmp(argv[i], "--no-ponder") == 0) {
+            use_ponder = 0;
+        } else if (strcmp(argv[i], "--batch") == 0) {
+            batch = 1;
+            if (i + 1 < argc && argv[i + 1][0] != '-') batch_file = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else {
+            return usage(argv[0]);
+        }
+    }
+    if (show_stats) {
+        /* batch output owns stdout */
+        metrics_set_enabled(1);
+        metrics_dump_at_exit(batch ? stderr : stdout, stats_format);
+    }
+
+    if (batch) {
+        FILE *in = batch_file ? fopen(batch_file, "rb") : stdin;
+        if (!in) {
+            fprintf(stderr, "Cannot open %s\n", batch_file);
+            return 1;
+        }
+        long n = batch_run(in, stdout, threads);
+        if (batch_file) fclose(in);
+        if (n < 0 || fflush(stdout) != 0) {
+            fprintf(stderr, "Batch analysis failed\n");
+            return 1;
+        }
+        return 0;
+    }
 
-int main(void) {
     char board[9];
     init_board(board);
 
@@ -32,6 +83,10 @@ int main(void) {
     char ai = (human == 'X') ? 'O' : 'X';
     int human_turn = (human == 'X');
 
+    /* The AI's replies are worked out while the human is choosing */
+    Ponder *ponder = use_ponder ? ponder_create() : NULL;
+    int pondering = 0;
+
     while (1) {
         print_board(board);
         char winner = check_winner(board);
@@ -44,6 +99,10 @@ int main(void) {
         if (human_turn) {
             int pos = -1;
             char line[128];
+            if (ponder && !pondering) {
+                ponder_start(ponder, board, ai, human);
+                pondering = 1;
+            }
             printf("Enter position (1-9) or Q to quit: ");
             if (!fgets(line, sizeof(line), stdin)) {
                 printf("No input, exiting.\n");
@@ -65,14 +124,25 @@ int main(void) {
             board[pos] = human;
         } else {
             printf("AI is thinking...\n");
-            int mv = get_best_move(board, ai, human);
+            SearchStats stats;
+            int mv;
+            int pondered = pondering && ponder_take(ponder, board, &mv, &stats);
+            pondering = 0;
+            if (!pondered) mv = get_best_move_ex(board, ai, human, &stats);
             board[mv] = ai;
             printf("AI plays %d\n", mv + 1);
+            if (show_stats) {
+                if (pondered) printf("  (ready from pondering, found in %.3f ms)\n", stats.time_ms);
+                else if (stats.table_hit) printf("  (table lookup, %.3f ms)\n", stats.time_ms);
+                else printf("  (%lu nodes, %lu cutoffs, %lu TT hits, depth %d, %.3f ms)\n", stats.nodes,
+                            stats.cutoffs, stats.tt_hits, stats.max_depth, stats.time_ms);
+            }
         }
 
         human_turn = !human_turn;
     }
 
     print_board(board);
+    ponder_destroy(ponder);
     return 0;
 }
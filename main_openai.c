@@ -5,6 +5,15 @@
 #include "ai.h"
 #include "openai_ai.h"
 
+// Prints explanation text as it streams in, after a heading on the first piece
+static void show_text(const char *text, size_t len, void *user) {
+    int *shown = user;
+    if (!*shown) printf("💭 AI says: ");
+    *shown = 1;
+    fwrite(text, 1, len, stdout);
+    fflush(stdout);
+}
+
 int main(void) {
     char board[9];
     init_board(board);
@@ -17,6 +26,7 @@ int main(void) {
     if (openai_init(api_key) != 0) {
         fprintf(stderr, "Failed to initialize OpenAI. Using local minimax AI instead.\n");
     }
+    openai_enable_cache("openai_moves.cache", 30L * 24 * 3600);
 
     printf("Choose AI opponent:\n");
     printf("1) Local Minimax AI (unbeatable, instant)\n");
@@ -54,8 +64,29 @@ int main(void) {
 
     printf("\n=== Game Start! ===\n");
 
+    OpenAIRequest *explaining = NULL;  // OpenAI's last move, until its explanation is shown
     while (1) {
         print_board(board);
+        if (explaining) {
+            const char *text;
+            OpenAIStatus st;
+            int shown = 0;
+            openai_on_explanation(explaining, show_text, &shown);
+            while ((st = openai_explanation_poll(explaining, &text)) == OPENAI_PENDING) openai_wait(100);
+            if (shown) printf("\n");
+            
+            OpenAITimings t;
+            openai_move_timings(explaining, &t);
+            if (t.cached && st != OPENAI_DONE)
+                printf("   (move from the cache)\n");
+            else
+                printf("   (%s%s connection: connect %.0f ms, TLS %.0f ms, first byte %.0f ms, "
+                       "move %.0f ms, total %.0f ms)\n",
+                       t.cached ? "move from the cache, explanation on " : "", t.reused ? "reused" : "new",
+                       t.connect_ms, t.tls_ms, t.ttfb_ms, t.move_ms, t.total_ms);
+            openai_move_cancel(explaining);
+            explaining = NULL;
+        }
         char winner = check_winner(board);
         if (winner != ' ') {
             if (winner == 'T') printf("\n🤝 Game over: It's a draw!\n");
@@ -93,20 +124,19 @@ int main(void) {
             int mv = -1;
             
             if (ai_choice == 2) {
-                // Use OpenAI
-                mv = openai_get_move(board, ai, human);
-                if (mv >= 0 && mv < 9 && board[mv] == ' ') {
+                // Use OpenAI: one request for the move and its explanation
+                OpenAIRequest *req = openai_turn_start(board, ai, human, 30000);
+                OpenAIStatus st = OPENAI_FAILED;
+                if (req) {
+                    while ((st = openai_move_poll(req, &mv)) == OPENAI_PENDING) openai_wait(100);
+                }
+                if (st == OPENAI_DONE && board[mv] == ' ') {
                     board[mv] = ai;
                     printf("AI plays position %d\n", mv + 1);
-                    
-                    // Get explanation
-                    char *explanation = openai_explain_move(board, mv, ai);
-                    if (explanation) {
-                        printf("💭 AI says: %s\n", explanation);
-                        free(explanation);
-                    }
+                    explaining = req;   // shown below the board once it arrives
                 } else {
                     // Fallback to minimax if OpenAI fails
+                    openai_move_cancel(req);
                     printf("OpenAI failed, using local AI...\n");
                     mv = get_best_move(board, ai, human);
                     board[mv] = ai;
@@ -126,6 +156,7 @@ int main(void) {
     print_board(board);
     printf("\nThanks for playing!\n");
     
+    openai_move_cancel(explaining);
     openai_cleanup();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,324 @@
+#include "mcts_ai.h"
+#include "timer.h"
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* UCT over MnkBoard. Nodes live in one contiguous arena: a node's children
+   are allocated together when it is expanded, so they sit next to each
+   other and are addressed by index. Nothing is freed during a search; the
+   arena is simply rewound when the tree is dropped.
+
+   Tree parallelism: threads share the tree under one lock for selection,
+   expansion and backpropagation, and run their playouts outside it. A
+   thread walking down adds VIRTUAL_LOSS visits to each node it passes, so
+   the others spread over different lines instead of piling onto one. */
+
+#define VIRTUAL_LOSS 3
+#define NEAR_RADIUS 2
+#define SMALL_BOARD 25
+#define MAX_THREADS 64
+
+typedef struct {
+    int parent;
+    int first_child;        /* -1 until expanded */
+    short child_count;
+    short move;             /* cell played to reach this node */
+    int visits;             /* includes virtual visits of playouts in flight */
+    float wins;             /* for the player who played `move`; draws count half */
+    signed char terminal;   /* 0 open, 1 `move` won, 2 board full */
+} MctsNode;
+
+/* See mcts_default_config */
+#define DEFAULT_CONFIG { 20000, 0, 1, 1.4, 1u << 20, 12345u }
+
+static MctsConfig config = DEFAULT_CONFIG;
+static MctsNode *arena;
+static size_t arena_cap;
+static size_t arena_used;
+
+/* The tree is kept between calls along with the position at its root */
+static int root = -1;
+static MnkBoard root_board;
+static char root_player;
+
+static pthread_mutex_t tree_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void mcts_default_config(MctsConfig *cfg) {
+    static const MctsConfig defaults = DEFAULT_CONFIG;
+    *cfg = defaults;
+}
+
+int mcts_configure(const MctsConfig *cfg) {
+    MctsNode *a = malloc(cfg->arena_nodes * sizeof(MctsNode));
+    if (!a) return -1;
+    free(arena);
+    arena = a;
+    arena_cap = cfg->arena_nodes;
+    config = *cfg;
+    if (config.threads < 1) config.threads = 1;
+    if (config.threads > MAX_THREADS) config.threads = MAX_THREADS;
+    mcts_reset();
+    return 0;
+}
+
+void mcts_reset(void) {
+    arena_used = 0;
+    root = -1;
+}
+
+static unsigned xorshift(unsigned *state) {
+    unsigned x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static int new_root(void) {
+    if (arena_used >= arena_cap) return -1;
+    MctsNode *n = &arena[arena_used];
+    n->parent = -1;
+    n->first_child = -1;
+    n->child_count = 0;
+    n->move = -1;
+    n->visits = 0;
+    n->wins = 0.0f;
+    n->terminal = 0;
+    return (int)arena_used++;
+}
+
+/* Allocates children for every sensible move of `b`: all empty cells on
+   small boards, cells near a stone on large ones. Leaves the node
+   unexpanded when the arena is full. */
+static void expand(int node, const MnkBoard *b) {
+    int first = (int)arena_used, count = 0;
+    for (int i = 0; i < b->size; ++i) {
+        if (mnk_at(b, i) != MNK_EMPTY) continue;
+        if (b->size > SMALL_BOARD && b->stones > 0) {
+            int r = i / b->width, c = i % b->width, near = 0;
+            for (int dr = -NEAR_RADIUS; dr <= NEAR_RADIUS && !near; ++dr)
+                for (int dc = -NEAR_RADIUS; dc <= NEAR_RADIUS && !near; ++dc) {
+                    int rr = r + dr, cc = c + dc;
+                    if (rr >= 0 && cc >= 0 && rr < b->height && cc < b->width &&
+                        mnk_at(b, rr * b->width + cc) != MNK_EMPTY) near = 1;
+                }
+            if (!near) continue;
+        }
+        if (arena_used + (size_t)count >= arena_cap) return;
+        MctsNode *n = &arena[first + count++];
+        n->parent = node;
+        n->first_child = -1;
+        n->child_count = 0;
+        n->move = (short)i;
+        n->visits = 0;
+        n->wins = 0.0f;
+        n->terminal = 0;
+    }
+    arena_used += (size_t)count;
+    arena[node].first_child = first;
+    arena[node].child_count = (short)count;
+}
+
+static int select_child(int node, unsigned *rng) {
+    const MctsNode *p = &arena[node];
+    double log_n = log((double)(p->visits + 1));
+    int best = -1;
+    double best_score = -1.0;
+    for (int c = p->first_child; c < p->first_child + p->child_count; ++c) {
+        const MctsNode *n = &arena[c];
+        double score;
+        if (n->visits == 0) score = 1e9 + (xorshift(rng) & 1023); /* unvisited first, in random order */
+        else score = n->wins / n->visits + config.exploration * sqrt(log_n / n->visits);
+        if (score > best_score) {
+            best_score = score;
+            best = c;
+        }
+    }
+    return best;
+}
+
+/* Plays random moves from `b` (with `to_move` next) until someone wins or
+   the board fills; returns the winner's symbol or 'T' */
+static char playout(MnkBoard *b, char to_move, unsigned *rng) {
+    int empty[MNK_MAX_W * MNK_MAX_H], n = 0;
+    for (int i = 0; i < b->size; ++i)
+        if (mnk_at(b, i) == MNK_EMPTY) empty[n++] = i;
+    while (n > 0) {
+        int k = (int)(xorshift(rng) % (unsigned)n);
+        int cell = empty[k];
+        empty[k] = empty[--n];
+        mnk_place(b, cell, to_move);
+        if (mnk_wins_at(b, cell)) return to_move;
+        to_move = (to_move == 'X') ? 'O' : 'X';
+    }
+    return 'T';
+}
+
+/* Shared by all threads searching one move */
+typedef struct {
+    char ai, human;
+    uint64_t deadline_ns;
+    int playouts_left;      /* guarded by tree_lock; < 0 when unlimited */
+} SearchJob;
+
+typedef struct {
+    SearchJob *job;
+    unsigned seed;
+} SearchThread;
+
+/* One selection / expansion / playout / backpropagation cycle.
+   Returns 0 once the playout budget is used up. */
+static int iterate(SearchJob *job, unsigned *rng) {
+    int path[MNK_MAX_W * MNK_MAX_H + 2], depth = 0;
+    MnkBoard b;
+    char to_move = job->ai;
+    char result;
+
+    pthread_mutex_lock(&tree_lock);
+    if (job->playouts_left == 0) {
+        pthread_mutex_unlock(&tree_lock);
+        return 0;
+    }
+    if (job->playouts_left > 0) job->playouts_left--;
+
+    memcpy(&b, &root_board, sizeof(MnkBoard));
+    int node = root;
+    path[depth++] = node;
+    arena[node].visits += VIRTUAL_LOSS;
+    for (;;) {
+        MctsNode *n = &arena[node];
+        if (n->terminal) break;
+        if (n->first_child < 0) {
+            if (n->visits > VIRTUAL_LOSS || node == root) expand(node, &b);
+            if (n->first_child < 0 || n->child_count == 0) break;
+        }
+        node = select_child(node, rng);
+        path[depth++] = node;
+        arena[node].visits += VIRTUAL_LOSS;
+        mnk_place(&b, arena[node].move, to_move);
+        if (mnk_wins_at(&b, arena[node].move)) arena[node].terminal = 1;
+        else if (b.stones == b.size) arena[node].terminal = 2;
+        to_move = (to_move == 'X') ? 'O' : 'X';
+    }
+    /* the player who made the last move on the path */
+    char last = (to_move == 'X') ? 'O' : 'X';
+    signed char terminal = arena[node].terminal;
+    pthread_mutex_unlock(&tree_lock);
+
+    if (terminal == 1) result = last;
+    else if (terminal == 2) result = 'T';
+    else result = playout(&b, to_move, rng);
+
+    pthread_mutex_lock(&tree_lock);
+    /* path[i] was reached by a move of the root player when i is odd */
+    for (int i = depth - 1; i >= 0; --i) {
+        MctsNode *n = &arena[path[i]];
+        char mover = (i % 2 == 1) ? job->ai : job->human;
+        n->visits += 1 - VIRTUAL_LOSS;
+        if (result == 'T') n->wins += 0.5f;
+        else if (result == mover) n->wins += 1.0f;
+    }
+    pthread_mutex_unlock(&tree_lock);
+    return 1;
+}
+
+static void *search_thread(void *arg) {
+    SearchThread *t = arg;
+    SearchJob *job = t->job;
+    unsigned rng = t->seed;
+    do {
+        if (job->deadline_ns && timer_now_ns() >= job->deadline_ns) break;
+    } while (iterate(job, &rng));
+    return NULL;
+}
+
+/* Moves the root to the subtree for `board`, or starts a new tree */
+static void reuse_or_reset(const MnkBoard *board, char ai) {
+    int node = root;
+    if (node >= 0 && board->width == root_board.width && board->height == root_board.height &&
+        board->k == root_board.k && board->stones >= root_board.stones &&
+        board->stones <= root_board.stones + 2) {
+        /* new stones must be our last move and the reply, in that order */
+        char player = root_player;
+        int added = 0;
+        for (int i = 0; i < board->size && node >= 0; ++i) {
+            char was = mnk_at(&root_board, i), now = mnk_at(board, i);
+            if (was == now) continue;
+            if (was != MNK_EMPTY) { node = -1; break; }
+            ++added;
+        }
+        for (int step = 0; node >= 0 && step < added; ++step) {
+            int next = -1;
+            const MctsNode *n = &arena[node];
+            for (int c = n->first_child; n->first_child >= 0 && c < n->first_child + n->child_count; ++c)
+                if (mnk_at(board, arena[c].move) == player && mnk_at(&root_board, arena[c].move) == MNK_EMPTY)
+                    next = c;
+            node = next;
+            player = (player == 'X') ? 'O' : 'X';
+        }
+        if (node >= 0 && player != ai) node = -1;
+    } else {
+        node = -1;
+    }
+
+    /* Old subtrees are not compacted; once the arena is half used start over */
+    if (node < 0 || arena_used > arena_cap / 2) {
+        arena_used = 0;
+        node = new_root();
+    } else {
+        arena[node].parent = -1;
+    }
+    root = node;
+    memcpy(&root_board, board, sizeof(MnkBoard));
+    root_player = ai;
+}
+
+int mcts_get_best_move(const MnkBoard *board, char ai, char human) {
+    uint64_t start = timer_now_ns();
+    if (!arena) {
+        MctsConfig cfg = config;
+        if (mcts_configure(&cfg) != 0) return 0;
+    }
+    reuse_or_reset(board, ai);
+    if (root < 0) return 0;
+
+    SearchJob job;
+    job.ai = ai;
+    job.human = human;
+    job.deadline_ns = (config.budget_ms > 0) ? start + (uint64_t)config.budget_ms * 1000000ULL : 0;
+    job.playouts_left = (config.playouts > 0) ? config.playouts : -1;
+    if (job.playouts_left < 0 && !job.deadline_ns) job.playouts_left = 20000;
+
+    SearchThread workers[MAX_THREADS];
+    pthread_t threads[MAX_THREADS];
+    int started = 0;
+    for (int t = 0; t < config.threads; ++t) {
+        workers[t].job = &job;
+        workers[t].seed = config.seed * 2654435761u + (unsigned)t * 40503u + (unsigned)board->stones + 1u;
+        if (workers[t].seed == 0) workers[t].seed = 1;
+    }
+    for (int t = 1; t < config.threads; ++t) {
+        if (pthread_create(&threads[t], NULL, search_thread, &workers[t]) != 0) break;
+        started++;
+    }
+    search_thread(&workers[0]);
+    for (int t = 1; t <= started; ++t) pthread_join(threads[t], NULL);
+
+    /* Most visited child; ties to the lower cell */
+    const MctsNode *r = &arena[root];
+    int best = -1, best_visits = -1;
+    for (int c = r->first_child; r->first_child >= 0 && c < r->first_child + r->child_count; ++c) {
+        if (arena[c].visits > best_visits ||
+            (arena[c].visits == best_visits && arena[c].move < arena[best].move)) {
+            best = c;
+            best_visits = arena[c].visits;
+        }
+    }
+    if (best < 0) {
+        for (int i = 0; i < board->size; ++i) if (mnk_at(board, i) == MNK_EMPTY) return i;
+        return 0;
+    }
+    return arena[best].move;
+}
@@ -0,0 +1,35 @@
+#ifndef MCTS_AI_H
+#define MCTS_AI_H
+
+#include <stddef.h>
+#include "mnk_game.h"
+
+/* Monte Carlo Tree Search (UCT) for m,n,k boards, for sizes where the
+   alpha-beta search cannot see far enough. Strength grows with the
+   playouts or time it is given. */
+
+typedef struct {
+    int playouts;           /* playouts per move, 0 = no limit */
+    int budget_ms;          /* wall-clock budget per move, 0 = no limit */
+    int threads;            /* tree-parallel threads, 1 = serial */
+    double exploration;     /* UCT exploration constant */
+    size_t arena_nodes;     /* node arena capacity */
+    unsigned seed;
+} MctsConfig;
+
+/* Defaults: 20000 playouts, no time limit, 1 thread, exploration 1.4, 1M nodes */
+void mcts_default_config(MctsConfig *cfg);
+
+/* Apply `cfg` to later searches. Drops the current tree. Returns 0, or -1
+   if the node arena could not be allocated. */
+int mcts_configure(const MctsConfig *cfg);
+
+/* Returns the logical index of the best move for `ai`. `human` is the
+   opponent symbol. When `board` follows from the previous call's board by
+   our move and the reply, the matching subtree is kept and searched further. */
+int mcts_get_best_move(const MnkBoard *board, char ai, char human);
+
+/* Forget the search tree, e.g. when a new game starts */
+void mcts_reset(void);
+
+#endif /* MCTS_AI_H */
@@ -0,0 +1,161 @@
+#include "metrics.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* A fixed table of metrics behind one lock. Updates happen once per engine
+   call or frame, not per node, so a single mutex is plenty. */
+
+#define MAX_METRICS 32
+#define MAX_BUCKETS 16
+#define NAME_LEN 64
+#define HELP_LEN 128
+
+enum { METRIC_COUNTER, METRIC_HISTOGRAM };
+
+struct Metric {
+    char name[NAME_LEN];
+    char help[HELP_LEN];
+    int type;
+    double value;                       /* counter total, or histogram sum */
+    int bucket_count;
+    double bounds[MAX_BUCKETS];
+    unsigned long long counts[MAX_BUCKETS + 1];   /* per bucket; the last is +Inf */
+    unsigned long long samples;
+};
+
+static const double default_bounds[] = { 1e-6, 1e-5, 1e-4, 1e-3, 1e-2, 1e-1, 1.0, 10.0 };
+
+static Metric registry[MAX_METRICS];
+static int metric_count;
+static int recording;
+static pthread_mutex_t registry_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static FILE *exit_out;
+static MetricsFormat exit_format;
+
+void metrics_set_enabled(int enabled) {
+    __atomic_store_n(&recording, enabled != 0, __ATOMIC_RELAXED);
+}
+
+int metrics_enabled(void) {
+    return __atomic_load_n(&recording, __ATOMIC_RELAXED);
+}
+
+static Metric *find_or_add(const char *name, const char *help, int type) {
+    Metric *m = NULL;
+    pthread_mutex_lock(&registry_lock);
+    for (int i = 0; i < metric_count; ++i) {
+        if (strcmp(registry[i].name, name) == 0) {
+            m = &registry[i];
+            break;
+        }
+    }
+    if (!m && metric_count < MAX_METRICS) {
+        m = &registry[metric_count++];
+        memset(m, 0, sizeof(*m));
+        strncpy(m->name, name, NAME_LEN - 1);
+        strncpy(m->help, help ? help : "", HELP_LEN - 1);
+        m->type = type;
+    }
+    pthread_mutex_unlock(&registry_lock);
+    return (m && m->type == type) ? m : NULL;
+}
+
+Metric *metrics_counter(const char *name, const char *help) {
+    return find_or_add(name, help, METRIC_COUNTER);
+}
+
+Metric *metrics_histogram(const char *name, const char *help, const double *bounds, int count) {
+    if (!bounds || count <= 0) {
+        bounds = default_bounds;
+        count = (int)(sizeof(default_bounds) / sizeof(default_bounds[0]));
+    }
+    if (count > MAX_BUCKETS) count = MAX_BUCKETS;
+    Metric *m = find_or_add(name, help, METRIC_HISTOGRAM);
+    if (m) {
+        pthread_mutex_lock(&registry_lock);
+        if (m->bucket_count == 0) {
+            memcpy(m->bounds, bounds, (size_t)count * sizeof(double));
+            m->bucket_count = count;
+        }
+        pthread_mutex_unlock(&registry_lock);
+    }
+    return m;
+}
+
+void metrics_add(Metric *m, double v) {
+    if (!m || !metrics_enabled()) return;
+    pthread_mutex_lock(&registry_lock);
+    m->value += v;
+    pthread_mutex_unlock(&registry_lock);
+}
+
+void metrics_observe(Metric *m, double v) {
+    if (!m || !metrics_enabled()) return;
+    int b = 0;
+    while (b < m->bucket_count && v > m->bounds[b]) ++b;
+    pthread_mutex_lock(&registry_lock);
+    m->counts[b]++;
+    m->samples++;
+    m->value += v;
+    pthread_mutex_unlock(&registry_lock);
+}
+
+static void dump_prometheus(FILE *out) {
+    for (int i = 0; i < metric_count; ++i) {
+        const Metric *m = &registry[i];
+        if (m->help[0]) fprintf(out, "# HELP %s %s\n", m->name, m->help);
+        if (m->type == METRIC_COUNTER) {
+            fprintf(out, "# TYPE %s counter\n%s %.17g\n", m->name, m->name, m->value);
+            continue;
+        }
+        fprintf(out, "# TYPE %s histogram\n", m->name);
+        unsigned long long cumulative = 0;
+        for (int b = 0; b < m->bucket_count; ++b) {
+            cumulative += m->counts[b];
+            fprintf(out, "%s_bucket{le=\"%g\"} %llu\n", m->name, m->bounds[b], cumulative);
+        }
+        fprintf(out, "%s_bucket{le=\"+Inf\"} %llu\n", m->name, m->samples);
+        fprintf(out, "%s_sum %.17g\n%s_count %llu\n", m->name, m->value, m->name, m->samples);
+    }
+}
+
+static void dump_json(FILE *out) {
+    fprintf(out, "{");
+    for (int i = 0; i < metric_count; ++i) {
+        const Metric *m = &registry[i];
+        fprintf(out, "%s\n  \"%s\": ", i ? "," : "", m->name);
+        if (m->type == METRIC_COUNTER) {
+            fprintf(out, "{\"type\": \"counter\", \"value\": %.17g}", m->value);
+            continue;
+        }
+        fprintf(out, "{\"type\": \"histogram\", \"buckets\": [");
+        unsigned long long cumulative = 0;
+        for (int b = 0; b < m->bucket_count; ++b) {
+            cumulative += m->counts[b];
+            fprintf(out, "%s{\"le\": %g, \"count\": %llu}", b ? ", " : "", m->bounds[b], cumulative);
+        }
+        fprintf(out, "], \"sum\": %.17g, \"count\": %llu}", m->value, m->samples);
+    }
+    fprintf(out, "%s}\n", metric_count ? "\n" : "");
+}
+
+void metrics_dump(FILE *out, MetricsFormat format) {
+    pthread_mutex_lock(&registry_lock);
+    if (format == METRICS_JSON) dump_json(out);
+    else dump_prometheus(out);
+    pthread_mutex_unlock(&registry_lock);
+    fflush(out);
+}
+
+static void dump_on_exit(void) {
+    metrics_dump(exit_out, exit_format);
+}
+
+void metrics_dump_at_exit(FILE *out, MetricsFormat format) {
+    int first = (exit_out == NULL);
+    exit_out = out;
+    exit_format = format;
+    if (first) atexit(dump_on_exit);
+}
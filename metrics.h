@@ -0,0 +1,38 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdio.h>
+
+/* Process-wide registry of named counters and histograms. Recording is off
+   until metrics_set_enabled(1), so instrumented code costs nothing by default. */
+
+typedef struct Metric Metric;
+
+typedef enum { METRICS_PROMETHEUS, METRICS_JSON } MetricsFormat;
+
+/* Turn recording on or off (off by default) */
+void metrics_set_enabled(int enabled);
+
+/* Non-zero while recording; callers check it before timing anything */
+int metrics_enabled(void);
+
+/* The counter called `name`, created on first use. NULL if the registry is full. */
+Metric *metrics_counter(const char *name, const char *help);
+
+/* The histogram called `name`, created on first use with `count` ascending bucket
+   bounds (NULL / 0 for latency buckets from 1 us to 10 s). NULL if the registry is full. */
+Metric *metrics_histogram(const char *name, const char *help, const double *bounds, int count);
+
+/* Add `v` to a counter; ignored for NULL or while recording is off */
+void metrics_add(Metric *m, double v);
+
+/* Record one sample in a histogram; ignored for NULL or while recording is off */
+void metrics_observe(Metric *m, double v);
+
+/* Write every metric in Prometheus text format or as a JSON object */
+void metrics_dump(FILE *out, MetricsFormat format);
+
+/* Call metrics_dump(out, format) when the process exits */
+void metrics_dump_at_exit(FILE *out, MetricsFormat format);
+
+#endif /* METRICS_H */
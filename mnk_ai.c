@@ -0,0 +1,458 @@
+#include "mnk_ai.h"
+#include "timer.h"
+#include <pthread.h>
+#include <string.h>
+
+/* Alpha-beta negamax over MnkBoard. Wins score MNK_WIN - ply so faster wins
+   and slower losses are preferred; at the depth horizon positions are
+   scored by counting open k-windows. Moves are generated only next to
+   existing stones, and immediate wins and forced blocks are resolved
+   before any recursion, using mnk_wins_at on the cell just played.
+
+   With more than one thread the search is split young-brothers-wait
+   style: a node searches its eldest child alone, and only once that has
+   not produced a cutoff are the remaining children published as a split
+   point that idle pool threads attach to and take moves from. Values do
+   not depend on which thread searched what, so the move chosen is the one
+   the serial search picks. */
+
+#define MNK_WIN 1000000
+#define MNK_INF (MNK_WIN + 1000)
+#define EVAL_CAP (MNK_WIN / 2)
+
+/* Boards up to this size consider every empty cell, larger ones only
+   cells within NEAR_RADIUS of a stone */
+#define SMALL_BOARD 25
+#define NEAR_RADIUS 2
+
+/* Only nodes with at least this many plies below them are split */
+#define SPLIT_MIN_DEPTH 2
+#define MAX_SPLIT_POINTS 64
+#define MAX_THREADS 64
+
+#define MAX_MOVES (MNK_MAX_W * MNK_MAX_H)
+
+typedef struct SplitPoint SplitPoint;
+
+typedef struct {
+    MnkBoard b;
+    unsigned long nodes;
+    uint64_t deadline_ns;   /* 0 = no time limit */
+    int horizon;            /* set when the depth limit cut a line short */
+    int aborted;            /* set when the deadline passed; results are void */
+    int *stop;              /* set when a deadline passes in any thread of this search */
+    int stop_flag;          /* what `stop` points at in the root search */
+    SplitPoint *sp;         /* innermost split point this thread works under */
+} Search;
+
+/* Remaining children of a node, shared by the threads searching them */
+struct SplitPoint {
+    pthread_mutex_t lock;
+    pthread_cond_t done;
+    SplitPoint *parent;     /* split point enclosing the owner, for cutoffs */
+    MnkBoard board;         /* position at the node */
+    uint64_t deadline_ns;
+    int *stop;              /* the owning search's stop flag */
+    char me, opp;
+    int ply, depth;
+    int root;               /* root node: ties go to the earlier move */
+    int alpha, beta, best, best_index;
+    int moves[MAX_MOVES];
+    int next, n;
+    int attached;           /* threads still taking moves from here */
+    int cutoff;
+    int horizon;
+    unsigned long nodes;    /* nodes searched by helper threads */
+};
+
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_work = PTHREAD_COND_INITIALIZER;
+
+/* Guarded by pool_lock */
+static struct {
+    pthread_t threads[MAX_THREADS];
+    int count;              /* helper threads running (threads - 1) */
+    int idle;
+    int shutdown;
+    SplitPoint *active[MAX_SPLIT_POINTS];
+    int active_count;
+} pool;
+
+static int search_stopped(Search *s) {
+    if (s->aborted) return 1;
+    if (__atomic_load_n(s->stop, __ATOMIC_RELAXED)) return s->aborted = 1;
+    for (SplitPoint *sp = s->sp; sp; sp = sp->parent)
+        if (__atomic_load_n(&sp->cutoff, __ATOMIC_RELAXED)) return 1;
+    return 0;
+}
+
+/* Sum over every k-window of a weight growing with the stones of one
+   side in it; windows holding both symbols count for nobody */
+static int evaluate(const MnkBoard *b, char me, char opp) {
+    const int dirs[4] = { 1, b->stride, b->stride + 1, b->stride - 1 };
+    long long score = 0;
+    for (int i = 0; i < b->size; ++i) {
+        int p = mnk_pad(b, i);
+        for (int d = 0; d < 4; ++d) {
+            int mine = 0, theirs = 0, q = p, j;
+            for (j = 0; j < b->k; ++j, q += dirs[d]) {
+                char c = b->cells[q];
+                if (c == MNK_BORDER) break;
+                if (c == me) ++mine;
+                else if (c == opp) ++theirs;
+            }
+            if (j < b->k || (mine && theirs)) continue;
+            int n = mine ? mine : theirs;
+            long long w = 1LL << (3 * (n < 6 ? n : 6));
+            score += mine ? w : (theirs ? -w : 0);
+        }
+    }
+    if (score > EVAL_CAP) score = EVAL_CAP;
+    if (score < -EVAL_CAP) score = -EVAL_CAP;
+    return (int)score;
+}
+
+/* Non-zero when playing `sym` at `idx` would complete k in a row */
+static int wins_with(MnkBoard *b, int idx, char sym) {
+    int p = mnk_pad(b, idx);
+    b->cells[p] = sym;
+    int w = mnk_wins_at(b, idx);
+    b->cells[p] = MNK_EMPTY;
+    return w;
+}
+
+/* Candidate moves for `me`, best first. Returns the count; sets *win to
+   a winning cell or -1. When `opp` threatens to win, only blocks are returned. */
+static int gen_moves(MnkBoard *b, char me, char opp, int *moves, int *win) {
+    int prio[MNK_MAX_W * MNK_MAX_H];
+    int n = 0, blocks = 0;
+    *win = -1;
+
+    if (b->stones == 0) {
+        moves[0] = (b->height / 2) * b->width + b->width / 2;
+        if (wins_with(b, moves[0], me)) *win = moves[0];
+        return 1;
+    }
+
+    for (int i = 0; i < b->size; ++i) {
+        if (mnk_at(b, i) != MNK_EMPTY) continue;
+        int r = i / b->width, c = i % b->width, near = 0;
+        for (int dr = -NEAR_RADIUS; dr <= NEAR_RADIUS; ++dr) {
+            for (int dc = -NEAR_RADIUS; dc <= NEAR_RADIUS; ++dc) {
+                int rr = r + dr, cc = c + dc;
+                if (rr < 0 || cc < 0 || rr >= b->height || cc >= b->width) continue;
+                char s = mnk_at(b, rr * b->width + cc);
+                if (s != MNK_EMPTY) near += (dr >= -1 && dr <= 1 && dc >= -1 && dc <= 1) ? 2 : 1;
+            }
+        }
+        if (!near && b->size > SMALL_BOARD) continue;
+
+        if (wins_with(b, i, me)) { *win = i; return 0; }
+        int p = near;
+        if (wins_with(b, i, opp)) { p += 1 << 20; ++blocks; }
+
+        /* insertion sort, stable for equal priorities */
+        int j = n++;
+        while (j > 0 && prio[j - 1] < p) { moves[j] = moves[j - 1]; prio[j] = prio[j - 1]; --j; }
+        moves[j] = i;
+        prio[j] = p;
+    }
+    /* Facing a threat, every other move loses at once */
+    return blocks ? blocks : n;
+}
+
+static int negamax(Search *s, char me, char opp, int ply, int depth, int alpha, int beta);
+
+/* Takes moves from `sp` until none are left or it is cut off. `s->b`
+   must hold the split position. */
+static void split_work(Search *s, SplitPoint *sp, int helper) {
+    SplitPoint *saved = s->sp;
+    s->sp = sp;
+    pthread_mutex_lock(&sp->lock);
+    while (!sp->cutoff && sp->next < sp->n) {
+        int k = sp->next++;
+        int mv = sp->moves[k];
+        int alpha = sp->root ? (k < sp->best_index ? sp->best - 1 : sp->best) : sp->alpha;
+        int beta = sp->beta;
+        pthread_mutex_unlock(&sp->lock);
+
+        mnk_place(&s->b, mv, sp->me);
+        int val = -negamax(s, sp->opp, sp->me, sp->ply + 1, sp->depth - 1, -beta, -alpha);
+        mnk_undo(&s->b, mv);
+
+        pthread_mutex_lock(&sp->lock);
+        if (helper) {
+            sp->nodes += s->nodes;
+            s->nodes = 0;
+        }
+        sp->horizon |= s->horizon;
+        if (search_stopped(s)) continue;
+        if (sp->root) {
+            /* Above its window the value is exact; the best may have moved
+               on since, and ties go to the earlier move */
+            if (val > alpha && (val > sp->best || (val == sp->best && k < sp->best_index))) {
+                sp->best = val;
+                sp->best_index = k;
+            }
+        } else if (val > sp->best) {
+            sp->best = val;
+            sp->best_index = k;
+            if (val > sp->alpha) sp->alpha = val;
+            if (sp->alpha >= sp->beta) __atomic_store_n(&sp->cutoff, 1, __ATOMIC_RELAXED);
+        }
+    }
+    if (--sp->attached == 0) pthread_cond_signal(&sp->done);
+    pthread_mutex_unlock(&sp->lock);
+    s->sp = saved;
+}
+
+static void *pool_thread(void *arg) {
+    (void)arg;
+    Search s;
+    pthread_mutex_lock(&pool_lock);
+    while (!pool.shutdown) {
+        SplitPoint *sp = NULL;
+        for (int i = 0; i < pool.active_count && !sp; ++i) {
+            SplitPoint *c = pool.active[i];
+            pthread_mutex_lock(&c->lock);
+            if (!c->cutoff && c->next < c->n) {
+                c->attached++;
+                sp = c;
+            }
+            pthread_mutex_unlock(&c->lock);
+        }
+        if (!sp) {
+            __atomic_add_fetch(&pool.idle, 1, __ATOMIC_RELAXED);
+            pthread_cond_wait(&pool_work, &pool_lock);
+            __atomic_sub_fetch(&pool.idle, 1, __ATOMIC_RELAXED);
+            continue;
+        }
+        pthread_mutex_unlock(&pool_lock);
+
+        memcpy(&s.b, &sp->board, sizeof(MnkBoard));
+        s.nodes = 0;
+        s.deadline_ns = sp->deadline_ns;
+        s.stop = sp->stop;
+        s.horizon = s.aborted = 0;
+        s.sp = NULL;
+        split_work(&s, sp, 1);
+
+        pthread_mutex_lock(&pool_lock);
+    }
+    pthread_mutex_unlock(&pool_lock);
+    return NULL;
+}
+
+static int can_split(int depth, int remaining) {
+    return depth >= SPLIT_MIN_DEPTH && remaining > 1 &&
+           __atomic_load_n(&pool.idle, __ATOMIC_RELAXED) > 0;
+}
+
+/* Searches moves[first..n) of the node in `s->b` together with idle pool
+   threads; `best` and `best_index` describe the children searched so far.
+   Returns the best value and stores the index of the move that gave it. */
+static int split_search(Search *s, char me, char opp, int ply, int depth, int alpha, int beta,
+                        int root, int best, const int *moves, int first, int n, int *best_index) {
+    SplitPoint sp;
+    pthread_mutex_init(&sp.lock, NULL);
+    pthread_cond_init(&sp.done, NULL);
+    sp.parent = s->sp;
+    memcpy(&sp.board, &s->b, sizeof(MnkBoard));
+    sp.deadline_ns = s->deadline_ns;
+    sp.stop = s->stop;
+    sp.me = me;
+    sp.opp = opp;
+    sp.ply = ply;
+    sp.depth = depth;
+    sp.root = root;
+    sp.alpha = alpha;
+    sp.beta = beta;
+    sp.best = best;
+    sp.best_index = *best_index;
+    memcpy(sp.moves, moves, (size_t)n * sizeof(int));
+    sp.next = first;
+    sp.n = n;
+    sp.attached = 1;
+    sp.cutoff = 0;
+    sp.horizon = 0;
+    sp.nodes = 0;
+
+    /* With the table full the owner simply searches the moves alone */
+    pthread_mutex_lock(&pool_lock);
+    if (pool.active_count < MAX_SPLIT_POINTS) {
+        pool.active[pool.active_count++] = &sp;
+        pthread_cond_broadcast(&pool_work);
+    }
+    pthread_mutex_unlock(&pool_lock);
+
+    split_work(s, &sp, 0);
+
+    pthread_mutex_lock(&sp.lock);
+    while (sp.attached > 0) pthread_cond_wait(&sp.done, &sp.lock);
+    pthread_mutex_unlock(&sp.lock);
+
+    pthread_mutex_lock(&pool_lock);
+    for (int i = 0; i < pool.active_count; ++i) {
+        if (pool.active[i] != &sp) continue;
+        pool.active[i] = pool.active[--pool.active_count];
+        break;
+    }
+    pthread_mutex_unlock(&pool_lock);
+
+    s->nodes += sp.nodes;
+    s->horizon |= sp.horizon;
+    search_stopped(s);   /* marks `s` aborted if a helper hit the deadline */
+    pthread_cond_destroy(&sp.done);
+    pthread_mutex_destroy(&sp.lock);
+    *best_index = sp.best_index;
+    return sp.best;
+}
+
+static int negamax(Search *s, char me, char opp, int ply, int depth, int alpha, int beta) {
+    s->nodes++;
+    if (s->deadline_ns && (s->nodes & 63) == 0 && timer_now_ns() >= s->deadline_ns) {
+        s->aborted = 1;
+        __atomic_store_n(s->stop, 1, __ATOMIC_RELAXED);
+    }
+    if (search_stopped(s)) return 0;
+    if (s->b.stones == s->b.size) return 0;
+    if (depth == 0) {
+        s->horizon = 1;
+        return evaluate(&s->b, me, opp);
+    }
+
+    int moves[MAX_MOVES], win;
+    int n = gen_moves(&s->b, me, opp, moves, &win);
+    if (win >= 0) return MNK_WIN - (ply + 1);
+
+    int best = -MNK_INF;
+    for (int k = 0; k < n; ++k) {
+        if (k > 0 && can_split(depth, n - k)) {
+            int index = 0;
+            return split_search(s, me, opp, ply, depth, alpha, beta, 0, best, moves, k, n, &index);
+        }
+        mnk_place(&s->b, moves[k], me);
+        int val = -negamax(s, opp, me, ply + 1, depth - 1, -beta, -alpha);
+        mnk_undo(&s->b, moves[k]);
+        if (search_stopped(s)) return 0;
+        if (val > best) {
+            best = val;
+            if (val > alpha) alpha = val;
+            if (alpha >= beta) break;
+        }
+    }
+    return best;
+}
+
+/* Searches `depth` plies below the root, trying `first` (if a candidate)
+   before the others; returns the move, -1 if none */
+static int search_root(Search *s, char me, char opp, int depth, int first, int *score) {
+    int moves[MAX_MOVES], win;
+    int n = gen_moves(&s->b, me, opp, moves, &win);
+    if (win >= 0) { *score = MNK_WIN; return win; }
+
+    for (int k = 1; k < n; ++k) {
+        if (moves[k] != first) continue;
+        for (; k > 0; --k) moves[k] = moves[k - 1];
+        moves[0] = first;
+        break;
+    }
+
+    int best = -MNK_INF, bestIndex = 0;
+    for (int k = 0; k < n; ++k) {
+        if (k > 0 && can_split(depth, n - k)) {
+            best = split_search(s, me, opp, -1, depth, -MNK_INF, MNK_INF, 1, best, moves, k, n, &bestIndex);
+            break;
+        }
+        mnk_place(&s->b, moves[k], me);
+        int val = -negamax(s, opp, me, 0, depth - 1, -MNK_INF, -best);
+        mnk_undo(&s->b, moves[k]);
+        if (s->aborted) break;
+        if (val > best) {
+            best = val;
+            bestIndex = k;
+        }
+    }
+    *score = best;
+    return n ? moves[bestIndex] : -1;
+}
+
+static void search_init(Search *s, const MnkBoard *board) {
+    memcpy(&s->b, board, sizeof(MnkBoard));
+    s->nodes = 0;
+    s->deadline_ns = 0;
+    s->horizon = s->aborted = 0;
+    s->sp = NULL;
+    s->stop_flag = 0;
+    s->stop = &s->stop_flag;
+}
+
+int mnk_ai_set_threads(int threads) {
+    if (threads < 1) threads = 1;
+    if (threads > MAX_THREADS) threads = MAX_THREADS;
+
+    pthread_mutex_lock(&pool_lock);
+    pool.shutdown = 1;
+    pthread_cond_broadcast(&pool_work);
+    pthread_mutex_unlock(&pool_lock);
+    for (int i = 0; i < pool.count; ++i) pthread_join(pool.threads[i], NULL);
+
+    pool.shutdown = 0;
+    pool.count = 0;
+    for (int i = 0; i < threads - 1; ++i) {
+        if (pthread_create(&pool.threads[i], NULL, pool_thread, NULL) != 0) break;
+        pool.count++;
+    }
+    return pool.count + 1;
+}
+
+int mnk_get_best_move_depth(const MnkBoard *board, char ai, char human, int depth) {
+    Search s;
+    search_init(&s, board);
+    if (depth < 1) depth = 1;
+
+    int score;
+    int mv = search_root(&s, ai, human, depth, -1, &score);
+    if (mv < 0) {
+        /* Board full; shouldn't be called in that state, but default to the first cell */
+        return 0;
+    }
+    return mv;
+}
+
+int mnk_get_best_move(const MnkBoard *board, char ai, char human) {
+    int empty = board->size - board->stones;
+    int depth = (empty <= 9) ? empty : MNK_DEFAULT_DEPTH;
+    return mnk_get_best_move_depth(board, ai, human, depth);
+}
+
+int mnk_get_best_move_timed(const MnkBoard *board, char ai, char human, int budget_ms, SearchInfo *info) {
+    uint64_t start = timer_now_ns();
+    Search s;
+    search_init(&s, board);
+
+    SearchInfo result = { 0, 0, 0 };
+    int best = -1;
+    for (int i = 0; i < board->size; ++i) if (mnk_at(board, i) == MNK_EMPTY) { best = i; break; }
+
+    /* The first iteration always completes; each later one starts from the
+       previous best move and is dropped if the budget runs out mid-way */
+    int empty = board->size - board->stones;
+    for (int d = 1; d <= empty; ++d) {
+        if (d == 2 && budget_ms > 0) s.deadline_ns = start + (uint64_t)budget_ms * 1000000ULL;
+        s.horizon = 0;
+        int score;
+        int mv = search_root(&s, ai, human, d, best, &score);
+        if (s.aborted) break;
+        if (mv >= 0) best = mv;
+        result.depth = d;
+        /* A forced win or loss needs no deeper look */
+        if (!s.horizon || score >= MNK_WIN - d || score <= -(MNK_WIN - d)) {
+            result.completed = !s.horizon;
+            break;
+        }
+    }
+    result.nodes = s.nodes;
+    if (info) *info = result;
+    return best < 0 ? 0 : best;
+}
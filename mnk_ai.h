@@ -0,0 +1,29 @@
+#ifndef MNK_AI_H
+#define MNK_AI_H
+
+#include "mnk_game.h"
+#include "ai.h"
+
+/* Returns the logical index of the best move for `ai` on an m,n,k board.
+   `human` is the opponent symbol. Boards with few empty cells are searched
+   to the end; otherwise the search stops after MNK_DEFAULT_DEPTH plies and
+   scores the position heuristically. */
+int mnk_get_best_move(const MnkBoard *board, char ai, char human);
+
+#define MNK_DEFAULT_DEPTH 4
+
+/* As mnk_get_best_move, searching at most `depth` plies */
+int mnk_get_best_move_depth(const MnkBoard *board, char ai, char human, int depth);
+
+/* Search with `threads` threads (1, the default, is serial). Extra threads
+   help with the remaining siblings of nodes whose first child has been
+   searched; the chosen move is the same as with one thread. Must not be
+   called while a search is running. Returns the thread count in effect.
+   Searches may run on several threads at once: they share the helper
+   threads, and each stops only at its own deadline. */
+int mnk_ai_set_threads(int threads);
+
+/* Iterative deepening within `budget_ms` (<= 0 for no limit); see get_best_move_timed */
+int mnk_get_best_move_timed(const MnkBoard *board, char ai, char human, int budget_ms, SearchInfo *info);
+
+#endif /* MNK_AI_H */
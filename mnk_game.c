@@ -0,0 +1,75 @@
+#include "mnk_game.h"
+#include <stdio.h>
+#include <string.h>
+
+int mnk_init(MnkBoard *b, int width, int height, int k) {
+    if (width < 1 || height < 1 || width > MNK_MAX_W || height > MNK_MAX_H) return -1;
+    if (k < 1 || (k > width && k > height)) return -1;
+
+    b->width = width;
+    b->height = height;
+    b->k = k;
+    b->stride = width + 1;
+    b->size = width * height;
+    b->stones = 0;
+
+    memset(b->cells, MNK_BORDER, sizeof(b->cells));
+    for (int i = 0; i < b->size; ++i) b->cells[mnk_pad(b, i)] = MNK_EMPTY;
+    return 0;
+}
+
+void mnk_from_board(MnkBoard *b, const char board[9]) {
+    mnk_init(b, 3, 3, 3);
+    for (int i = 0; i < 9; ++i)
+        if (board[i] == 'X' || board[i] == 'O') mnk_place(b, i, board[i]);
+}
+
+void mnk_place(MnkBoard *b, int idx, char sym) {
+    b->cells[mnk_pad(b, idx)] = sym;
+    b->stones++;
+}
+
+void mnk_undo(MnkBoard *b, int idx) {
+    b->cells[mnk_pad(b, idx)] = MNK_EMPTY;
+    b->stones--;
+}
+
+void mnk_print_board(const MnkBoard *b) {
+    printf("\n");
+    for (int r = 0; r < b->height; ++r) {
+        for (int c = 0; c < b->width; ++c) {
+            printf(" %c ", mnk_at(b, r * b->width + c));
+            if (c < b->width - 1) printf("|");
+        }
+        if (r < b->height - 1) {
+            printf("\n");
+            for (int c = 0; c < b->width; ++c) printf(c < b->width - 1 ? "---+" : "---");
+            printf("\n");
+        }
+    }
+    printf("\n\n");
+}
+
+/* Length of the run of `sym` through padded cell `p` along +/-`dir` */
+static int run_length(const char *cells, int p, int dir, char sym) {
+    int n = 1;
+    for (int q = p + dir; cells[q] == sym; q += dir) ++n;
+    for (int q = p - dir; cells[q] == sym; q -= dir) ++n;
+    return n;
+}
+
+int mnk_wins_at(const MnkBoard *b, int idx) {
+    int p = mnk_pad(b, idx);
+    char sym = b->cells[p];
+    if (sym != 'X' && sym != 'O') return 0;
+    const int dirs[4] = { 1, b->stride, b->stride + 1, b->stride - 1 };
+    for (int d = 0; d < 4; ++d)
+        if (run_length(b->cells, p, dirs[d], sym) >= b->k) return 1;
+    return 0;
+}
+
+char mnk_check_winner(const MnkBoard *b) {
+    for (int i = 0; i < b->size; ++i)
+        if (mnk_wins_at(b, i)) return mnk_at(b, i);
+    return (b->stones == b->size) ? 'T' : ' ';
+}
@@ -0,0 +1,64 @@
+#ifndef MNK_GAME_H
+#define MNK_GAME_H
+
+/* Generalized m,n,k board: `width` x `height` cells, `k` in a row wins
+   (3,3,3 is tic-tac-toe, 15,15,5 is gomoku).
+
+   Cells are stored row-major with a sentinel border: each row is followed
+   by one MNK_BORDER cell (shared as the left edge of the next row) and
+   there is a border row above and below, so direction scans stop at the
+   edge without bounds checks. Functions take and return logical indices
+   row * width + col, like the 0-8 indices of the 3x3 board. */
+
+#define MNK_MAX_W 19
+#define MNK_MAX_H 19
+#define MNK_MAX_CELLS ((MNK_MAX_H + 2) * (MNK_MAX_W + 1) + 1)
+
+#define MNK_EMPTY ' '
+#define MNK_BORDER '#'
+
+typedef struct {
+    int width, height, k;
+    int stride;                 /* width + 1: one border cell per row */
+    int size;                   /* width * height */
+    int stones;                 /* stones on the board */
+    char cells[MNK_MAX_CELLS];  /* padded layout, see mnk_pad */
+} MnkBoard;
+
+/* Initialize an empty board. Returns 0, or -1 if the dimensions are out of range. */
+int mnk_init(MnkBoard *b, int width, int height, int k);
+
+/* Initialize a 3,3,3 board from the classic board[9] */
+void mnk_from_board(MnkBoard *b, const char board[9]);
+
+/* Padded cell offset of logical index `idx`, and back */
+static inline int mnk_pad(const MnkBoard *b, int idx) {
+    return (idx / b->width + 1) * b->stride + idx % b->width + 1;
+}
+static inline int mnk_unpad(const MnkBoard *b, int p) {
+    return (p / b->stride - 1) * b->width + p % b->stride - 1;
+}
+
+/* Symbol at logical index `idx` ('X', 'O' or MNK_EMPTY) */
+static inline char mnk_at(const MnkBoard *b, int idx) {
+    return b->cells[mnk_pad(b, idx)];
+}
+
+/* Place `sym` at an empty cell, or clear it again */
+void mnk_place(MnkBoard *b, int idx, char sym);
+void mnk_undo(MnkBoard *b, int idx);
+
+/* Print board to stdout */
+void mnk_print_board(const MnkBoard *b);
+
+/* Non-zero when the stone at `idx` is part of k in a row. Only the four
+   directions through that cell are scanned, so call it after each move
+   instead of re-checking the whole board. */
+int mnk_wins_at(const MnkBoard *b, int idx);
+
+/* Same contract as check_winner: 'X', 'O', 'T' for tie, ' ' while ongoing.
+   Scans every stone; prefer mnk_wins_at after a move when the position
+   was undecided before it. */
+char mnk_check_winner(const MnkBoard *b);
+
+#endif /* MNK_GAME_H */
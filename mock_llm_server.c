@@ -0,0 +1,434 @@
+#define _POSIX_C_SOURCE 200809L
+#include <arpa/inet.h>
+#include <errno.h>
+#include <math.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Local stand-in for the chat-completions API, so the OpenAI code path can
+   be run and benchmarked offline (POSIX sockets only).
+
+   Usage: mock_llm_server [--port N] [--latency DIST] [--error-rate P]
+                          [--error-status CODE] [--timeout-rate P]
+                          [--drip-rate P] [--drip-ms MS] [--bad-move-rate P]
+                          [--token-ms MS] [--seed S] [--verbose]
+
+   Answers POST .../chat/completions with a random legal move for the board
+   named in the prompt: a bare digit, a {"move", "explanation"} object when
+   the request sets response_format, or a sentence for "Explain" prompts.
+   A request with "stream": true is answered with server-sent events
+   instead, a few characters of the text per event, --token-ms apart
+   (default 20). Each request first waits a delay drawn from DIST:
+     fixed:MS  uniform:LO:HI  normal:MEAN:SD  lognormal:MEDIAN:SIGMA
+   Faults are drawn per request: --error-rate answers with --error-status
+   (default 500), --timeout-rate never answers, --drip-rate sends the reply
+   a few bytes at a time (or streams its events) --drip-ms apart, and --bad-move-rate answers with
+   text naming no move. Ctrl-C prints what was served. */
+
+typedef enum { LAT_FIXED, LAT_UNIFORM, LAT_NORMAL, LAT_LOGNORMAL } LatencyKind;
+
+typedef struct {
+    LatencyKind kind;
+    double a, b;
+} Latency;
+
+static struct {
+    int port;
+    Latency latency;
+    double error_rate, timeout_rate, drip_rate, bad_rate;
+    int error_status;
+    int drip_ms;
+    int token_ms;
+    unsigned seed;
+    int verbose;
+} opts = { 8089, { LAT_FIXED, 0, 0 }, 0, 0, 0, 0, 500, 50, 20, 1u, 0 };
+
+#define DRIP_BYTES 16
+#define TOKEN_CHARS 4           /* characters of message text per streamed event */
+#define MAX_REQUEST (64 << 10)
+#define HOLD_SECONDS 120        /* a "timeout" keeps the connection at most this long */
+
+static unsigned long served, errors, timeouts, drips, bad_moves;
+static unsigned long next_connection;
+static volatile sig_atomic_t stopping;
+
+typedef struct {
+    unsigned long long state;
+} Rng;
+
+static double rng_uniform(Rng *r) {
+    r->state ^= r->state << 13;
+    r->state ^= r->state >> 7;
+    r->state ^= r->state << 17;
+    return (r->state >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static double rng_normal(Rng *r) {
+    double u = rng_uniform(r), v = rng_uniform(r);
+    if (u < 1e-300) u = 1e-300;
+    return sqrt(-2.0 * log(u)) * cos(6.283185307179586 * v);
+}
+
+static double sample_latency_ms(Rng *r) {
+    const Latency *l = &opts.latency;
+    double ms;
+    switch (l->kind) {
+    case LAT_UNIFORM: ms = l->a + (l->b - l->a) * rng_uniform(r); break;
+    case LAT_NORMAL: ms = l->a + l->b * rng_normal(r); break;
+    case LAT_LOGNORMAL: ms = l->a * exp(l->b * rng_normal(r)); break;
+    case LAT_FIXED:
+    default: ms = l->a; break;
+    }
+    return ms > 0 ? ms : 0;
+}
+
+static void sleep_ms(double ms) {
+    struct timespec ts;
+    ts.tv_sec = (time_t)(ms / 1000);
+    ts.tv_nsec = (long)((ms - ts.tv_sec * 1000.0) * 1e6);
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR && !stopping) {}
+}
+
+static int send_all(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        data += n;
+        len -= (size_t)n;
+    }
+    return 0;
+}
+
+/* Sends `data` as one chunk of a chunked body */
+static int send_chunk(int fd, const char *data, size_t len) {
+    char size[32];
+    int n = snprintf(size, sizeof(size), "%zx\r\n", len);
+    if (send_all(fd, size, (size_t)n) != 0 || send_all(fd, data, len) != 0) return -1;
+    return send_all(fd, "\r\n", 2);
+}
+
+/* Length of the next piece of escaped JSON text, about TOKEN_CHARS long
+   and never splitting an escape */
+static size_t token_length(const char *text) {
+    size_t len = 0;
+    while (text[len] && len < TOKEN_CHARS) {
+        if (text[len] != '\\') len++;
+        else if (text[len + 1] == 'u') len += 6;
+        else len += 2;
+    }
+    return len;
+}
+
+/* Streams `content` as chat.completion.chunk events, `pause_ms` apart */
+static int stream_reply(int fd, unsigned long id, const char *model, const char *content, int pause_ms) {
+    static const char head[] = "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\n"
+                               "Cache-Control: no-cache\r\nTransfer-Encoding: chunked\r\n\r\n";
+    char event[512];
+    if (send_all(fd, head, sizeof(head) - 1) != 0) return -1;
+    for (const char *p = content; *p;) {
+        size_t len = token_length(p);
+        int n = snprintf(event, sizeof(event),
+                         "data: {\"id\":\"chatcmpl-mock-%lu\",\"object\":\"chat.completion.chunk\",\"model\":\"%s\","
+                         "\"choices\":[{\"index\":0,\"delta\":{\"content\":\"%.*s\"},\"finish_reason\":null}]}\n\n",
+                         id, model, (int)len, p);
+        if (send_chunk(fd, event, (size_t)n) != 0) return -1;
+        p += len;
+        if (*p) sleep_ms(pause_ms);
+    }
+    static const char done[] = "data: [DONE]\n\n";
+    if (send_chunk(fd, done, sizeof(done) - 1) != 0) return -1;
+    return send_all(fd, "0\r\n\r\n", 5);
+}
+
+/* Value of header `name` in the request head, or NULL; `*len` gets its length */
+static const char *header_value(const char *head, size_t head_len, const char *name, size_t *len) {
+    size_t name_len = strlen(name);
+    const char *end = head + head_len;
+    for (const char *line = head; line < end;) {
+        const char *eol = line;
+        while (eol < end && *eol != '\r' && *eol != '\n') eol++;
+        if ((size_t)(eol - line) > name_len && line[name_len] == ':' && strncasecmp(line, name, name_len) == 0) {
+            const char *v = line + name_len + 1;
+            while (v < eol && *v == ' ') v++;
+            *len = (size_t)(eol - v);
+            return v;
+        }
+        line = eol;
+        while (line < end && (*line == '\r' || *line == '\n')) line++;
+    }
+    return NULL;
+}
+
+/* The 9-cell board after the last "board: " in the prompt, or 0 if none */
+static int find_board(const char *body, char board[9]) {
+    const char *found = NULL;
+    for (const char *p = strstr(body, "board: "); p; p = strstr(p + 1, "board: ")) found = p + 7;
+    if (!found) return 0;
+    for (int i = 0; i < 9; i++) {
+        char c = found[i];
+        if (c != 'X' && c != 'O' && c != '-') return 0;
+        board[i] = c;
+    }
+    return 1;
+}
+
+static int random_empty_cell(const char board[9], Rng *r) {
+    int empty[9], n = 0;
+    for (int i = 0; i < 9; i++)
+        if (board[i] == '-') empty[n++] = i;
+    return n ? empty[(int)(rng_uniform(r) * n) % n] : 0;
+}
+
+/* Writes the message text (already escaped for a JSON string) into `out` */
+static void build_content(const char *body, Rng *r, char *out, size_t size) {
+    char board[9];
+    int have_board = find_board(body, board);
+    int move = have_board ? random_empty_cell(board, r) : 4;
+    int bad = rng_uniform(r) < opts.bad_rate;
+    if (bad) __atomic_fetch_add(&bad_moves, 1, __ATOMIC_RELAXED);
+
+    if (strstr(body, "\"response_format\"")) {
+        if (bad) snprintf(out, size, "{\\\"explanation\\\": \\\"No idea.\\\"}");
+        else snprintf(out, size, "{\\\"move\\\": %d, \\\"explanation\\\": \\\"Cell %d keeps the most "
+                                 "lines open and answers the threat on the board.\\\"}", move, move);
+    } else if (strstr(body, "Explain")) {
+        snprintf(out, size, "It takes a line away from the opponent while keeping two of its own open.");
+    } else if (bad) {
+        snprintf(out, size, "I would rather not say.");
+    } else {
+        snprintf(out, size, "%d", move);
+    }
+}
+
+/* Copies the "model" member of the request, or "mock" */
+static void request_model(const char *body, char *out, size_t size) {
+    snprintf(out, size, "mock");
+    const char *p = strstr(body, "\"model\"");
+    if (!p || !(p = strchr(p + 7, '"'))) return;
+    const char *end = strchr(++p, '"');
+    if (end && (size_t)(end - p) < size) snprintf(out, size, "%.*s", (int)(end - p), p);
+}
+
+/* Non-zero if the request line is "POST <...>/chat/completions HTTP/..." */
+static int is_chat_request(const char *head, size_t head_len) {
+    static const char suffix[] = "/chat/completions";
+    const char *path = head + 5, *end = path;
+    if (head_len < 5 || strncmp(head, "POST ", 5) != 0) return 0;
+    while (end < head + head_len && *end != ' ' && *end != '\r') end++;
+    size_t len = (size_t)(end - path);
+    return len >= sizeof(suffix) - 1 && memcmp(end - (sizeof(suffix) - 1), suffix, sizeof(suffix) - 1) == 0;
+}
+
+/* Answers one request; returns -1 if the connection should be closed */
+static int handle_request(int fd, const char *head, size_t head_len, const char *body, Rng *r) {
+    char response[4096], reply[2048];
+    int n;
+    if (!is_chat_request(head, head_len)) {
+        const char *msg = "{\"error\": {\"message\": \"not found\", \"type\": \"invalid_request_error\"}}";
+        n = snprintf(response, sizeof(response),
+                     "HTTP/1.1 404 Not Found\r\nContent-Type: application/json\r\nContent-Length: %zu\r\n\r\n%s",
+                     strlen(msg), msg);
+        return send_all(fd, response, (size_t)n);
+    }
+
+    double roll = rng_uniform(r);
+    if (roll < opts.timeout_rate) {
+        /* Never answer; wait for the client to give up and hang up */
+        __atomic_fetch_add(&timeouts, 1, __ATOMIC_RELAXED);
+        char sink[256];
+        while (!stopping && recv(fd, sink, sizeof(sink), 0) > 0) {}
+        return -1;
+    }
+    sleep_ms(sample_latency_ms(r));
+
+    if (roll < opts.timeout_rate + opts.error_rate) {
+        __atomic_fetch_add(&errors, 1, __ATOMIC_RELAXED);
+        int len = snprintf(reply, sizeof(reply),
+                           "{\"error\": {\"message\": \"mock failure\", \"type\": \"server_error\", \"code\": %d}}",
+                           opts.error_status);
+        n = snprintf(response, sizeof(response),
+                     "HTTP/1.1 %d Mock Error\r\nContent-Type: application/json\r\nContent-Length: %d\r\n\r\n%s",
+                     opts.error_status, len, reply);
+        return send_all(fd, response, (size_t)n);
+    }
+
+    char content[1024], model[64];
+    build_content(body, r, content, sizeof(content));
+    request_model(body, model, sizeof(model));
+    unsigned long id = __atomic_add_fetch(&served, 1, __ATOMIC_RELAXED);
+    if (strstr(body, "\"stream\": true")) {
+        int pause_ms = opts.token_ms;
+        if (rng_uniform(r) < opts.drip_rate) {
+            __atomic_fetch_add(&drips, 1, __ATOMIC_RELAXED);
+            pause_ms = opts.drip_ms;
+        }
+        return stream_reply(fd, id, model, content, pause_ms);
+    }
+    int len = snprintf(reply, sizeof(reply),
+                       "{\"id\": \"chatcmpl-mock-%lu\", \"object\": \"chat.completion\", \"created\": %ld, "
+                       "\"model\": \"%s\", \"choices\": [{\"index\": 0, \"message\": {\"role\": \"assistant\", "
+                       "\"content\": \"%s\"}, \"finish_reason\": \"stop\"}], "
+                       "\"usage\": {\"prompt_tokens\": 80, \"completion_tokens\": 20, \"total_tokens\": 100}}",
+                       id, (long)time(NULL), model, content);
+    n = snprintf(response, sizeof(response),
+                 "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: %d\r\n\r\n", len);
+
+    if (rng_uniform(r) < opts.drip_rate) {
+        __atomic_fetch_add(&drips, 1, __ATOMIC_RELAXED);
+        if (send_all(fd, response, (size_t)n) != 0) return -1;
+        for (int off = 0; off < len; off += DRIP_BYTES) {
+            sleep_ms(opts.drip_ms);
+            int chunk = len - off < DRIP_BYTES ? len - off : DRIP_BYTES;
+            if (send_all(fd, reply + off, (size_t)chunk) != 0) return -1;
+        }
+        return 0;
+    }
+    if ((size_t)n + (size_t)len >= sizeof(response)) return -1;
+    memcpy(response + n, reply, (size_t)len);
+    return send_all(fd, response, (size_t)n + (size_t)len);
+}
+
+static const char *find_head_end(const char *buf, size_t len) {
+    for (size_t i = 3; i < len; i++)
+        if (buf[i] == '\n' && buf[i - 1] == '\r' && buf[i - 2] == '\n' && buf[i - 3] == '\r') return buf + i + 1;
+    return NULL;
+}
+
+/* Serves requests on one keep-alive connection until the client hangs up */
+static void *connection_main(void *arg) {
+    int fd = (int)(long)arg;
+    unsigned long conn = __atomic_add_fetch(&next_connection, 1, __ATOMIC_RELAXED);
+    Rng rng = { (opts.seed * 0x9E3779B97F4A7C15ull) ^ (conn * 0xBF58476D1CE4E5B9ull) };
+    if (rng.state == 0) rng.state = 1;
+
+    char *buf = malloc(MAX_REQUEST + 1);
+    size_t len = 0;
+    while (buf && !stopping) {
+        const char *body;
+        while (!(body = find_head_end(buf, len))) {
+            if (len == MAX_REQUEST) goto done;
+            ssize_t got = recv(fd, buf + len, MAX_REQUEST - len, 0);
+            if (got <= 0) goto done;
+            len += (size_t)got;
+        }
+        size_t head_len = (size_t)(body - buf), vlen;
+        const char *v = header_value(buf, head_len, "Content-Length", &vlen);
+        size_t body_len = v ? strtoul(v, NULL, 10) : 0;
+        if (head_len + body_len > MAX_REQUEST) break;
+        while (len < head_len + body_len) {
+            ssize_t got = recv(fd, buf + len, MAX_REQUEST - len, 0);
+            if (got <= 0) goto done;
+            len += (size_t)got;
+        }
+
+        /* The body is handled as a string; keep the byte after it */
+        char saved = buf[head_len + body_len];
+        buf[head_len + body_len] = '\0';
+        v = header_value(buf, head_len, "Connection", &vlen);
+        int close_after = v && vlen == 5 && strncasecmp(v, "close", 5) == 0;
+        if (opts.verbose) fprintf(stderr, "conn %lu: %.*s\n", conn, (int)(strchr(buf, '\r') - buf), buf);
+        int rc = handle_request(fd, buf, head_len, buf + head_len, &rng);
+        buf[head_len + body_len] = saved;
+        if (rc != 0 || close_after) break;
+
+        len -= head_len + body_len;
+        memmove(buf, buf + head_len + body_len, len);
+    }
+done:
+    free(buf);
+    close(fd);
+    return NULL;
+}
+
+static int parse_latency(const char *spec, Latency *l) {
+    int n = 0;
+    if (sscanf(spec, "fixed:%lf%n", &l->a, &n) == 1 && !spec[n]) l->kind = LAT_FIXED;
+    else if (sscanf(spec, "uniform:%lf:%lf%n", &l->a, &l->b, &n) == 2 && !spec[n]) l->kind = LAT_UNIFORM;
+    else if (sscanf(spec, "normal:%lf:%lf%n", &l->a, &l->b, &n) == 2 && !spec[n]) l->kind = LAT_NORMAL;
+    else if (sscanf(spec, "lognormal:%lf:%lf%n", &l->a, &l->b, &n) == 2 && !spec[n]) l->kind = LAT_LOGNORMAL;
+    else return -1;
+    return 0;
+}
+
+static void on_signal(int sig) {
+    (void)sig;
+    stopping = 1;
+}
+
+static int usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [--port N] [--latency DIST] [--error-rate P] [--error-status CODE]\n"
+                    "          [--timeout-rate P] [--drip-rate P] [--drip-ms MS] [--bad-move-rate P]\n"
+                    "          [--token-ms MS] [--seed S] [--verbose]\n"
+                    "DIST: fixed:MS, uniform:LO:HI, normal:MEAN:SD, lognormal:MEDIAN:SIGMA\n", prog);
+    return 2;
+}
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i], *val = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!strcmp(arg, "--verbose")) { opts.verbose = 1; continue; }
+        if (!val) return usage(argv[0]);
+        ++i;
+        if (!strcmp(arg, "--port")) opts.port = atoi(val);
+        else if (!strcmp(arg, "--latency")) { if (parse_latency(val, &opts.latency) != 0) return usage(argv[0]); }
+        else if (!strcmp(arg, "--error-rate")) opts.error_rate = atof(val);
+        else if (!strcmp(arg, "--error-status")) opts.error_status = atoi(val);
+        else if (!strcmp(arg, "--timeout-rate")) opts.timeout_rate = atof(val);
+        else if (!strcmp(arg, "--drip-rate")) opts.drip_rate = atof(val);
+        else if (!strcmp(arg, "--drip-ms")) opts.drip_ms = atoi(val);
+        else if (!strcmp(arg, "--bad-move-rate")) opts.bad_rate = atof(val);
+        else if (!strcmp(arg, "--token-ms")) opts.token_ms = atoi(val);
+        else if (!strcmp(arg, "--seed")) opts.seed = (unsigned)strtoul(val, NULL, 10);
+        else return usage(argv[0]);
+    }
+    if (opts.port <= 0 || opts.port > 65535) return usage(argv[0]);
+
+    /* No SA_RESTART, so accept returns on Ctrl-C */
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons((unsigned short)opts.port);
+    if (listener < 0 || bind(listener, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(listener, 64) != 0) {
+        perror("mock_llm_server");
+        return 1;
+    }
+    fprintf(stderr, "mock LLM server on http://127.0.0.1:%d/v1\n", opts.port);
+
+    while (!stopping) {
+        int fd = accept(listener, NULL, NULL);
+        if (fd < 0) continue;
+        struct timeval hold = { HOLD_SECONDS, 0 };
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &hold, sizeof(hold));
+        pthread_t tid;
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        if (pthread_create(&tid, &attr, connection_main, (void *)(long)fd) != 0) close(fd);
+        pthread_attr_destroy(&attr);
+    }
+    close(listener);
+    fprintf(stderr, "served %lu replies (%lu dripped, %lu without a move), %lu errors, %lu timeouts\n",
+            served, drips, bad_moves, errors, timeouts);
+    return 0;
+}
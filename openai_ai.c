@@ -1,32 +1,114 @@
+#define _POSIX_C_SOURCE 200809L  // strdup
 #include "openai_ai.h"
+#include "llm_cache.h"
+#include "metrics.h"
+#include "timer.h"
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <curl/curl.h>
 
 static char api_key[256] = {0};
+static char model[64] = "gpt-3.5-turbo";
+static char endpoint[256] = "https://api.openai.com/v1/chat/completions";
+static long blocking_timeout_ms = 30000L;   // of openai_get_move / openai_explain_move
+static LlmCache *cache;                 // move answers, see openai_enable_cache
 
+// Growable byte buffer, kept NUL-terminated. It starts at BUFFER_INITIAL
+// bytes and doubles, so a reply arriving in many small chunks costs a few
+// reallocations instead of one per chunk.
 typedef struct {
     char *data;
     size_t size;
+    size_t cap;
 } ResponseData;
 
-static size_t write_callback(void *contents, size_t size, size_t nmemb, void *userp) {
-    size_t realsize = size * nmemb;
-    ResponseData *mem = (ResponseData *)userp;
-    
-    char *ptr = realloc(mem->data, mem->size + realsize + 1);
-    if (!ptr) {
-        fprintf(stderr, "Out of memory\n");
-        return 0;
+#define BUFFER_INITIAL 4096
+
+static int buffer_append(ResponseData *buf, const char *bytes, size_t len) {
+    if (buf->size + len + 1 > buf->cap) {
+        size_t cap = buf->cap ? buf->cap : BUFFER_INITIAL;
+        while (cap < buf->size + len + 1) cap *= 2;
+        char *ptr = realloc(buf->data, cap);
+        if (!ptr) {
+            fprintf(stderr, "Out of memory\n");
+            return -1;
+        }
+        buf->data = ptr;
+        buf->cap = cap;
     }
-    
-    mem->data = ptr;
-    memcpy(&(mem->data[mem->size]), contents, realsize);
-    mem->size += realsize;
-    mem->data[mem->size] = 0;
-    
-    return realsize;
+    memcpy(buf->data + buf->size, bytes, len);
+    buf->size += len;
+    buf->data[buf->size] = '\0';
+    return 0;
+}
+
+static void buffer_free(ResponseData *buf) {
+    free(buf->data);
+    buf->data = NULL;
+    buf->size = buf->cap = 0;
+}
+
+// Client state kept for the whole session so DNS lookups, TCP and TLS
+// handshakes happen once: a share handle holds the DNS cache, TLS sessions
+// and open connections, and finished easy handles go back to a pool with
+// their options still set.
+#define IDLE_HANDLES 4
+
+static struct {
+    CURLSH *share;
+    CURLM *multi;                       // transfers started by openai_move_start
+    struct OpenAIRequest *orphans;      // cancelled after the move, left to finish
+    struct curl_slist *headers;
+    CURL *idle[IDLE_HANDLES];
+    int idle_count;
+    OpenAITimings last;                 // of the latest blocking call
+    pthread_mutex_t lock;               // guards idle and last
+    pthread_mutex_t share_locks[CURL_LOCK_DATA_LAST];
+} client = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static void share_lock(CURL *handle, curl_lock_data data, curl_lock_access access, void *userp) {
+    (void)handle; (void)access; (void)userp;
+    pthread_mutex_lock(&client.share_locks[data]);
+}
+
+static void share_unlock(CURL *handle, curl_lock_data data, void *userp) {
+    (void)handle; (void)userp;
+    pthread_mutex_unlock(&client.share_locks[data]);
+}
+
+void openai_set_model(const char *name) {
+    if (!name || !*name) return;
+    strncpy(model, name, sizeof(model) - 1);
+    model[sizeof(model) - 1] = '\0';
+}
+
+const char *openai_model(void) {
+    return model;
+}
+
+void openai_set_base_url(const char *url) {
+    if (!url || !*url) return;
+    size_t len = strlen(url);
+    while (len > 0 && url[len - 1] == '/') len--;
+    snprintf(endpoint, sizeof(endpoint), "%.*s/chat/completions", (int)len, url);
+}
+
+void openai_set_timeout(int timeout_ms) {
+    blocking_timeout_ms = timeout_ms > 0 ? timeout_ms : 30000L;
+}
+
+int openai_enable_cache(const char *path, long ttl_seconds) {
+    llm_cache_close(cache);
+    cache = llm_cache_open(path, 4096, ttl_seconds);
+    return cache ? 0 : -1;
+}
+
+int openai_cache_stats(LlmCacheStats *stats) {
+    if (!cache) return -1;
+    llm_cache_stats(cache, stats);
+    return 0;
 }
 
 int openai_init(const char *key) {
@@ -37,99 +119,486 @@ int openai_init(const char *key) {
     strncpy(api_key, key, sizeof(api_key) - 1);
     api_key[sizeof(api_key) - 1] = '\0';
     
+    const char *env_model = getenv("OPENAI_MODEL");
+    if (env_model && *env_model) openai_set_model(env_model);
+    const char *env_url = getenv("OPENAI_BASE_URL");
+    if (env_url && *env_url) openai_set_base_url(env_url);
+    
     curl_global_init(CURL_GLOBAL_DEFAULT);
+    
+    // Build the headers once; every request sends the same ones
+    char auth_header[512];
+    snprintf(auth_header, sizeof(auth_header), "Authorization: Bearer %s", api_key);
+    curl_slist_free_all(client.headers);
+    client.headers = curl_slist_append(NULL, "Content-Type: application/json");
+    client.headers = curl_slist_append(client.headers, auth_header);
+    
+    if (!client.share) {
+        for (int i = 0; i < CURL_LOCK_DATA_LAST; i++) pthread_mutex_init(&client.share_locks[i], NULL);
+        client.share = curl_share_init();
+        if (client.share) {
+            curl_share_setopt(client.share, CURLSHOPT_LOCKFUNC, share_lock);
+            curl_share_setopt(client.share, CURLSHOPT_UNLOCKFUNC, share_unlock);
+            curl_share_setopt(client.share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+            curl_share_setopt(client.share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+            curl_share_setopt(client.share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+        }
+    }
     return 0;
 }
 
+// What a request asks the model for
+typedef enum {
+    ASK_MOVE,               // a bare digit
+    ASK_TURN,               // a JSON object with the move and an explanation
+    ASK_EXPLANATION         // text on a move already known
+} Ask;
+
+struct OpenAIRequest {
+    CURL *curl;             // NULL when there is nothing to fetch
+    char body[4096];        // CURLOPT_POSTFIELDS does not copy, so the request owns it
+    ResponseData response;  // raw bytes received
+    Ask ask;
+    char board[9];
+    char player;
+    int move;               // -1 until known
+    int parsed;             // reply already picked apart
+    uint64_t start_ns;
+    int done;
+    CURLcode result;
+    OpenAITimings timings;
+    
+    // Streaming: the reply arrives as server-sent events, each carrying a
+    // piece of the message text, and is read as it comes in
+    int stream;
+    size_t sse_pos;         // start of the first event line not yet read
+    int streamed;           // at least one event seen
+    ResponseData content;   // message text so far
+    ResponseData explanation;
+    size_t expl_pos;        // ASK_TURN: where the explanation continues in `content`, 0 until found
+    int expl_done;          // explanation complete
+    size_t delivered;       // explanation bytes already passed to on_text
+    OpenAITextFn on_text;
+    void *on_text_user;
+    int orphaned;           // cancelled, left to finish so its connection can be reused
+    struct OpenAIRequest *next_orphan;
+};
+
+static void stream_feed(OpenAIRequest *req);
+static void request_free(OpenAIRequest *req);
+
+static size_t write_callback(void *contents, size_t size, size_t nmemb, void *userp) {
+    size_t realsize = size * nmemb;
+    OpenAIRequest *req = (OpenAIRequest *)userp;
+    if (buffer_append(&req->response, contents, realsize) != 0) return 0;
+    if (req->stream) stream_feed(req);
+    return realsize;
+}
+
 void openai_cleanup(void) {
+    while (client.orphans) {
+        OpenAIRequest *req = client.orphans;
+        client.orphans = req->next_orphan;
+        curl_multi_remove_handle(client.multi, req->curl);
+        request_free(req);
+        free(req);
+    }
+    if (client.multi) {
+        curl_multi_cleanup(client.multi);
+        client.multi = NULL;
+    }
+    for (int i = 0; i < client.idle_count; i++) curl_easy_cleanup(client.idle[i]);
+    client.idle_count = 0;
+    if (client.share) {
+        curl_share_cleanup(client.share);
+        client.share = NULL;
+        for (int i = 0; i < CURL_LOCK_DATA_LAST; i++) pthread_mutex_destroy(&client.share_locks[i]);
+    }
+    curl_slist_free_all(client.headers);
+    client.headers = NULL;
+    llm_cache_close(cache);
+    cache = NULL;
     curl_global_cleanup();
 }
 
-static char* call_openai(const char *prompt) {
-    CURL *curl = curl_easy_init();
-    if (!curl) {
+// An easy handle with the per-session options set, from the pool if one is idle
+static CURL *acquire_handle(void) {
+    CURL *curl = NULL;
+    pthread_mutex_lock(&client.lock);
+    if (client.idle_count > 0) curl = client.idle[--client.idle_count];
+    pthread_mutex_unlock(&client.lock);
+    if (curl) return curl;
+    
+    curl = curl_easy_init();
+    if (!curl) return NULL;
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, client.headers);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);   // an error body must not be read as a move
+    if (client.share) curl_easy_setopt(curl, CURLOPT_SHARE, client.share);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPIDLE, 60L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPINTVL, 30L);
+    curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+    curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+    return curl;
+}
+
+static void release_handle(CURL *curl) {
+    if (!curl) return;
+    pthread_mutex_lock(&client.lock);
+    if (client.idle_count < IDLE_HANDLES) {
+        client.idle[client.idle_count++] = curl;
+        curl = NULL;
+    }
+    pthread_mutex_unlock(&client.lock);
+    if (curl) curl_easy_cleanup(curl);
+}
+
+// Copies `s` into `out` as the inside of a JSON string
+static void json_escape(const char *s, char *out, size_t size) {
+    size_t n = 0;
+    for (; *s && n + 7 < size; s++) {
+        unsigned char c = (unsigned char)*s;
+        if (c == '"' || c == '\\') {
+            out[n++] = '\\';
+            out[n++] = (char)c;
+        } else if (c < 0x20) {
+            n += (size_t)snprintf(out + n, size - n, "\\u%04x", c);
+        } else {
+            out[n++] = (char)c;
+        }
+    }
+    out[n] = '\0';
+}
+
+// Prepares `req` to post `prompt`, asking for a JSON object back if `json_reply`
+// and for server-sent events if `stream`. Returns 0 on success.
+static int request_init(OpenAIRequest *req, const char *prompt, long timeout_ms, int json_reply, int stream) {
+    req->curl = acquire_handle();
+    if (!req->curl) {
         fprintf(stderr, "Failed to initialize curl\n");
-        return NULL;
+        return -1;
     }
     
-    ResponseData response = {0};
-    
     // Build JSON request
-    char json_request[4096];
-    snprintf(json_request, sizeof(json_request),
+    char content[1024];
+    json_escape(prompt, content, sizeof(content));
+    snprintf(req->body, sizeof(req->body),
         "{"
-        "\"model\": \"gpt-3.5-turbo\","
+        "\"model\": \"%s\","
         "\"messages\": [{\"role\": \"user\", \"content\": \"%s\"}],"
+        "%s%s"
         "\"temperature\": 0.7,"
         "\"max_tokens\": 150"
-        "}", prompt);
+        "}", model, content, json_reply ? "\"response_format\": {\"type\": \"json_object\"}," : "",
+        stream ? "\"stream\": true," : "");
+    req->stream = stream;
     
-    // Build authorization header
-    char auth_header[512];
-    snprintf(auth_header, sizeof(auth_header), "Authorization: Bearer %s", api_key);
-    
-    struct curl_slist *headers = NULL;
-    headers = curl_slist_append(headers, "Content-Type: application/json");
-    headers = curl_slist_append(headers, auth_header);
-    
-    curl_easy_setopt(curl, CURLOPT_URL, "https://api.openai.com/v1/chat/completions");
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, json_request);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&response);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L);
-    
-    CURLcode res = curl_easy_perform(curl);
+    curl_easy_setopt(req->curl, CURLOPT_URL, endpoint);
+    curl_easy_setopt(req->curl, CURLOPT_POSTFIELDS, req->body);
+    curl_easy_setopt(req->curl, CURLOPT_WRITEDATA, (void *)req);
+    curl_easy_setopt(req->curl, CURLOPT_TIMEOUT_MS, timeout_ms);
+    curl_easy_setopt(req->curl, CURLOPT_PRIVATE, (void *)req);
+    req->start_ns = timer_now_ns();
+    return 0;
+}
+
+static void request_free(OpenAIRequest *req) {
+    release_handle(req->curl);
+    req->curl = NULL;
+    buffer_free(&req->response);
+    buffer_free(&req->content);
+    buffer_free(&req->explanation);
+}
+
+// Splits curl's cumulative timestamps into phases
+static void read_timings(CURL *curl, OpenAITimings *t) {
+    curl_off_t dns = 0, connect = 0, tls = 0, first = 0, total = 0;
+    long connects = 0;
+    curl_easy_getinfo(curl, CURLINFO_NAMELOOKUP_TIME_T, &dns);
+    curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &connect);
+    curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME_T, &tls);
+    curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME_T, &first);
+    curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &total);
+    curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
+    t->dns_ms = dns / 1000.0;
+    t->connect_ms = connect > dns ? (connect - dns) / 1000.0 : 0.0;
+    t->tls_ms = tls > connect ? (tls - connect) / 1000.0 : 0.0;
+    t->ttfb_ms = first / 1000.0;
+    t->total_ms = total / 1000.0;
+    t->reused = (connects == 0);
+}
+
+static void record_result(OpenAIRequest *req, CURLcode res) {
+    int cached = req->timings.cached;
+    read_timings(req->curl, &req->timings);
+    req->timings.cached = cached;
+    if (!metrics_enabled()) return;
+    metrics_add(metrics_counter("openai_requests_total", "Requests sent to the OpenAI API"), 1);
+    if (res != CURLE_OK)
+        metrics_add(metrics_counter("openai_errors_total", "OpenAI requests that failed"), 1);
+    metrics_observe(metrics_histogram("openai_request_seconds", "OpenAI request latency", NULL, 0),
+                    timer_elapsed_ms(req->start_ns) / 1000.0);
+    if (req->timings.reused) {
+        metrics_add(metrics_counter("openai_connections_reused_total", "Requests sent on an open connection"), 1);
+    } else {
+        metrics_observe(metrics_histogram("openai_connect_seconds", "TCP connect time of new connections", NULL, 0),
+                        req->timings.connect_ms / 1000.0);
+        metrics_observe(metrics_histogram("openai_tls_seconds", "TLS handshake time of new connections", NULL, 0),
+                        req->timings.tls_ms / 1000.0);
+    }
+    metrics_observe(metrics_histogram("openai_ttfb_seconds", "Time to the first response byte", NULL, 0),
+                    req->timings.ttfb_ms / 1000.0);
+}
+
+static char* call_openai(const char *prompt) {
+    OpenAIRequest req;
+    memset(&req, 0, sizeof(req));
+    if (request_init(&req, prompt, blocking_timeout_ms, 0, 0) != 0) return NULL;
     
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
+    CURLcode res = curl_easy_perform(req.curl);
+    record_result(&req, res);
+    pthread_mutex_lock(&client.lock);
+    client.last = req.timings;
+    pthread_mutex_unlock(&client.lock);
     
     if (res != CURLE_OK) {
         fprintf(stderr, "curl_easy_perform() failed: %s\n", curl_easy_strerror(res));
-        if (response.data) free(response.data);
+        request_free(&req);
         return NULL;
     }
     
-    return response.data;
+    char *data = req.response.data;
+    req.response.data = NULL;
+    request_free(&req);
+    return data;
 }
 
-int openai_get_move(const char board[9], char player, char opponent) {
-    char board_str[32];
-    char prompt[512];
-    
-    // Convert board to string
+void openai_last_timings(OpenAITimings *t) {
+    pthread_mutex_lock(&client.lock);
+    *t = client.last;
+    pthread_mutex_unlock(&client.lock);
+}
+
+static void board_string(const char board[9], char out[10]) {
     for (int i = 0; i < 9; i++) {
-        board_str[i] = (board[i] == ' ') ? '-' : board[i];
+        out[i] = (board[i] == ' ') ? '-' : board[i];
     }
-    board_str[9] = '\0';
-    
-    snprintf(prompt, sizeof(prompt),
+    out[9] = '\0';
+}
+
+static void build_move_prompt(const char board[9], char player, char opponent, char *prompt, size_t size) {
+    char board_str[10];
+    board_string(board, board_str);
+    snprintf(prompt, size,
         "You are playing Tic-Tac-Toe. The board is represented as a 9-character string "
         "where positions 0-8 correspond to: 0|1|2, 3|4|5, 6|7|8. "
         "Current board: %s (- means empty). "
         "You are '%c', opponent is '%c'. "
         "Reply with ONLY a single digit 0-8 for your best move. No explanation.",
         board_str, player, opponent);
+}
+
+// The move comes first in the reply so it can be read before the explanation is done
+static void build_turn_prompt(const char board[9], char player, char opponent, char *prompt, size_t size) {
+    char board_str[10];
+    board_string(board, board_str);
+    snprintf(prompt, size,
+        "You are playing Tic-Tac-Toe. The board is represented as a 9-character string "
+        "where positions 0-8 correspond to: 0|1|2, 3|4|5, 6|7|8. "
+        "Current board: %s (- means empty). "
+        "You are '%c', opponent is '%c'. "
+        "Reply with ONLY a JSON object of the form "
+        "{\"move\": <digit 0-8>, \"explanation\": \"<why, in 1-2 sentences>\"}, move first.",
+        board_str, player, opponent);
+}
+
+static void build_explain_prompt(const char board[9], int move, char player, char *prompt, size_t size) {
+    char board_str[10];
+    board_string(board, board_str);
+    snprintf(prompt, size,
+        "Explain in 1-2 sentences why playing '%c' at position %d "
+        "is a good move in this Tic-Tac-Toe board: %s (positions 0-8).",
+        player, move, board_str);
+}
+
+// Appends code point `cp` to `out` as UTF-8; returns the bytes written
+static size_t put_utf8(unsigned cp, char *out) {
+    if (cp < 0x80) {
+        out[0] = (char)cp;
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = (char)(0xC0 | cp >> 6);
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = (char)(0xE0 | cp >> 12);
+        out[1] = (char)(0x80 | (cp >> 6 & 0x3F));
+        out[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | cp >> 18);
+    out[1] = (char)(0x80 | (cp >> 12 & 0x3F));
+    out[2] = (char)(0x80 | (cp >> 6 & 0x3F));
+    out[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+// Reads 4 hex digits; 0 if `p` ends first, -1 if they are not hex, else 1
+static int hex4(const char *p, unsigned *v) {
+    *v = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        unsigned d;
+        if (c == '\0') return 0;
+        if (c >= '0' && c <= '9') d = (unsigned)(c - '0');
+        else if (c >= 'a' && c <= 'f') d = (unsigned)(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') d = (unsigned)(c - 'A' + 10);
+        else return -1;
+        *v = *v << 4 | d;
+    }
+    return 1;
+}
+
+// Decodes the character of a JSON string body at `p` (not its closing quote) into
+// `out`, which needs room for 4 bytes, and sets `*out_len`. Returns the input bytes
+// used, 0 if `p` ends in the middle of it (text still arriving), -1 if malformed.
+static int json_char(const char *p, char *out, size_t *out_len) {
+    *out_len = 1;
+    if (*p == '\0') return 0;
+    if (*p != '\\') {
+        out[0] = *p;
+        return 1;
+    }
+    switch (p[1]) {
+    case '\0': return 0;
+    case 'n': out[0] = '\n'; return 2;
+    case 't': out[0] = '\t'; return 2;
+    case 'r': out[0] = '\r'; return 2;
+    case 'b': out[0] = '\b'; return 2;
+    case 'f': out[0] = '\f'; return 2;
+    case 'u': {
+        unsigned cp, lo;
+        int ok = hex4(p + 2, &cp);
+        if (ok <= 0) return ok;
+        if (cp >= 0xD800 && cp < 0xDC00) {
+            // A high surrogate pairs with a following \uDC00-\uDFFF
+            if (p[6] == '\0' || (p[6] == '\\' && p[7] == '\0')) return 0;
+            if (p[6] == '\\' && p[7] == 'u') {
+                ok = hex4(p + 8, &lo);
+                if (ok == 0) return 0;
+                if (ok > 0 && lo >= 0xDC00 && lo < 0xE000) {
+                    *out_len = put_utf8(0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00), out);
+                    return 12;
+                }
+            }
+        }
+        *out_len = put_utf8(cp, out);
+        return 6;
+    }
+    default: out[0] = p[1]; return 2;      // \" \\ \/
+    }
+}
+
+// Where the string value of the first `"key":` in `json` starts (after its opening
+// quote), or NULL if there is none yet
+static const char *json_string_start(const char *json, const char *key) {
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\"", key);
+    const char *p = strstr(json, pattern);
+    if (!p) return NULL;
+    p += strlen(pattern);
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') p++;
+    if (*p++ != ':') return NULL;
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') p++;
+    if (*p++ != '"') return NULL;
+    return p;
+}
+
+// The string value of the first `"key":` in `json`, unescaped, or NULL.
+// Free the result.
+static char *json_string_field(const char *json, const char *key) {
+    const char *p = json_string_start(json, key);
+    if (!p) return NULL;
+    
+    // Unescaping never makes the text longer
+    char *out = malloc(strlen(p) + 1);
+    if (!out) return NULL;
+    size_t n = 0, len;
+    while (*p != '"') {
+        int used = json_char(p, out + n, &len);
+        if (used <= 0) {
+            free(out);
+            return NULL;
+        }
+        p += used;
+        n += len;
+    }
+    out[n] = '\0';
+    return out;
+}
+
+// First digit in `text` naming an empty cell, or -1
+static int parse_move(const char *text, const char board[9]) {
+    for (const char *p = text; *p; p++) {
+        if (*p >= '0' && *p <= '8' && board[*p - '0'] == ' ') return *p - '0';
+    }
+    return -1;
+}
+
+// The "move" member of a turn reply if it names an empty cell, or -1; works on
+// a reply still arriving
+static int move_member(const char *text, const char board[9]) {
+    const char *p = strstr(text, "\"move\"");
+    if (!p) return -1;
+    p += 6;
+    while (*p == ' ' || *p == ':' || *p == '"') p++;
+    if (*p >= '0' && *p <= '8' && board[*p - '0'] == ' ') return *p - '0';
+    return -1;
+}
+
+// The "move" member of a turn reply, or the first legal digit if it has none
+static int parse_turn_move(const char *text, const char board[9]) {
+    int move = move_member(text, board);
+    return move >= 0 ? move : parse_move(text, board);
+}
+
+// Message text of a chat completion, or NULL. Free the result.
+static char *reply_content(const char *response) {
+    return json_string_field(response, "content");
+}
+
+int openai_get_move(const char board[9], char player, char opponent) {
+    int move;
+    if (cache && llm_cache_get(cache, board, player, model, &move) && board[move] == ' ') {
+        pthread_mutex_lock(&client.lock);
+        memset(&client.last, 0, sizeof(client.last));
+        client.last.cached = 1;
+        pthread_mutex_unlock(&client.lock);
+        return move;
+    }
+    
+    char prompt[512];
+    build_move_prompt(board, player, opponent, prompt, sizeof(prompt));
     
     char *response = call_openai(prompt);
     if (!response) return -1;
     
     // Parse response to extract move
-    int move = -1;
-    for (size_t i = 0; i < strlen(response); i++) {
-        if (response[i] >= '0' && response[i] <= '8') {
-            move = response[i] - '0';
-            // Verify move is valid
-            if (board[move] == ' ') {
-                break;
-            }
-        }
-    }
-    
+    char *content = reply_content(response);
+    move = parse_move(content ? content : response, board);
+    free(content);
     free(response);
+    if (move != -1 && cache) llm_cache_put(cache, board, player, model, move);
     
     // Fallback: find first empty space if parsing failed
-    if (move == -1 || board[move] != ' ') {
+    if (move == -1) {
+        pthread_mutex_lock(&client.lock);
+        client.last.guessed = 1;
+        pthread_mutex_unlock(&client.lock);
         for (int i = 0; i < 9; i++) {
             if (board[i] == ' ') {
                 move = i;
@@ -141,44 +610,307 @@ int openai_get_move(const char board[9], char player, char opponent) {
     return move;
 }
 
-char* openai_explain_move(const char board[9], int move, char player) {
-    char board_str[32];
+// Starts posting `prompt` in the background, streaming the reply
+static OpenAIRequest *request_start(Ask ask, const char board[9], char player, const char *prompt, int timeout_ms) {
+    if (!client.multi) {
+        client.multi = curl_multi_init();
+        if (!client.multi) return NULL;
+        curl_multi_setopt(client.multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    }
+    OpenAIRequest *req = calloc(1, sizeof(OpenAIRequest));
+    if (!req) return NULL;
+    
+    if (request_init(req, prompt, timeout_ms > 0 ? timeout_ms : 30000L, ask == ASK_TURN, 1) != 0) {
+        free(req);
+        return NULL;
+    }
+    req->ask = ask;
+    memcpy(req->board, board, 9);
+    req->player = player;
+    req->move = -1;
+    if (curl_multi_add_handle(client.multi, req->curl) != CURLM_OK) {
+        request_free(req);
+        free(req);
+        return NULL;
+    }
+    
+    // Get the connection going; this returns as soon as it would have to wait
+    int running;
+    curl_multi_perform(client.multi, &running);
+    return req;
+}
+
+// A finished request holding a move from the cache
+static OpenAIRequest *cached_request(int move) {
+    OpenAIRequest *req = calloc(1, sizeof(OpenAIRequest));
+    if (!req) return NULL;
+    req->ask = ASK_MOVE;
+    req->move = move;
+    req->done = 1;
+    req->parsed = 1;
+    req->timings.cached = 1;
+    return req;
+}
+
+OpenAIRequest *openai_move_start(const char board[9], char player, char opponent, int timeout_ms) {
+    int move;
+    if (cache && llm_cache_get(cache, board, player, model, &move) && board[move] == ' ')
+        return cached_request(move);
+    
     char prompt[512];
+    build_move_prompt(board, player, opponent, prompt, sizeof(prompt));
+    return request_start(ASK_MOVE, board, player, prompt, timeout_ms);
+}
+
+OpenAIRequest *openai_turn_start(const char board[9], char player, char opponent, int timeout_ms) {
+    char prompt[512];
+    int move;
+    if (cache && llm_cache_get(cache, board, player, model, &move) && board[move] == ' ') {
+        // The move is known already; only the explanation has to be fetched
+        build_explain_prompt(board, move, player, prompt, sizeof(prompt));
+        OpenAIRequest *req = request_start(ASK_EXPLANATION, board, player, prompt, timeout_ms);
+        if (!req) return cached_request(move);
+        req->move = move;
+        req->timings.cached = 1;
+        return req;
+    }
     
-    for (int i = 0; i < 9; i++) {
-        board_str[i] = (board[i] == ' ') ? '-' : board[i];
+    build_turn_prompt(board, player, opponent, prompt, sizeof(prompt));
+    return request_start(ASK_TURN, board, player, prompt, timeout_ms);
+}
+
+void openai_move_timings(const OpenAIRequest *req, OpenAITimings *t) {
+    *t = req->timings;
+}
+
+static void set_move(OpenAIRequest *req, int move) {
+    req->move = move;
+    req->timings.move_ms = timer_elapsed_ms(req->start_ns);
+    if (cache && req->ask != ASK_EXPLANATION) llm_cache_put(cache, req->board, req->player, model, move);
+    if (metrics_enabled())
+        metrics_observe(metrics_histogram("openai_move_seconds", "Time until the move of a request was known",
+                                          NULL, 0), req->timings.move_ms / 1000.0);
+}
+
+// Passes explanation text not yet seen to the callback
+static void deliver(OpenAIRequest *req) {
+    if (req->on_text && req->explanation.size > req->delivered) {
+        size_t from = req->delivered;
+        req->delivered = req->explanation.size;
+        req->on_text(req->explanation.data + from, req->explanation.size - from, req->on_text_user);
+    }
+}
+
+// Decodes as much of the explanation string in `content` as has arrived
+static void decode_explanation(OpenAIRequest *req) {
+    const char *p = req->content.data + req->expl_pos;
+    char out[4];
+    size_t len;
+    while (*p != '"') {
+        int used = json_char(p, out, &len);
+        if (used == 0) break;               // the rest is still on its way
+        if (used < 0) {
+            req->expl_done = 1;             // malformed; keep what there is
+            break;
+        }
+        if (buffer_append(&req->explanation, out, len) != 0) break;
+        p += used;
+    }
+    if (*p == '"') req->expl_done = 1;
+    req->expl_pos = (size_t)(p - req->content.data);
+}
+
+// Acts on the message text received so far: takes the move as soon as it
+// appears and decodes explanation text as it streams in
+static void scan_content(OpenAIRequest *req, const char *piece, size_t len) {
+    const char *text = req->content.data;
+    switch (req->ask) {
+    case ASK_MOVE:
+        if (req->move < 0) {
+            int mv = parse_move(text, req->board);
+            if (mv >= 0) set_move(req, mv);
+        }
+        break;
+    case ASK_TURN:
+        if (req->move < 0) {
+            int mv = move_member(text, req->board);
+            if (mv >= 0) set_move(req, mv);
+        }
+        if (!req->expl_pos) {
+            const char *start = json_string_start(text, "explanation");
+            if (start) req->expl_pos = (size_t)(start - text);
+        }
+        if (req->expl_pos && !req->expl_done) decode_explanation(req);
+        break;
+    case ASK_EXPLANATION:
+        buffer_append(&req->explanation, piece, len);
+        break;
     }
-    board_str[9] = '\0';
+    deliver(req);
+}
+
+// Reads the complete event lines received so far. Each "data: {...}" event
+// carries the next piece of the message in choices[0].delta.content.
+static void stream_feed(OpenAIRequest *req) {
+    for (;;) {
+        char *line = req->response.data + req->sse_pos;
+        char *nl = memchr(line, '\n', req->response.size - req->sse_pos);
+        if (!nl) break;
+        req->sse_pos = (size_t)(nl + 1 - req->response.data);
+        if (strncmp(line, "data:", 5) != 0) continue;
+        req->streamed = 1;
+        
+        *nl = '\0';     // events are read one line at a time
+        const char *payload = line + 5;
+        while (*payload == ' ') payload++;
+        char *piece = strncmp(payload, "[DONE]", 6) == 0 ? NULL : json_string_field(payload, "content");
+        *nl = '\n';
+        if (!piece) continue;
+        if (*piece) {
+            size_t len = strlen(piece);
+            if (req->content.size == 0 && metrics_enabled())
+                metrics_observe(metrics_histogram("openai_first_token_seconds", "Time to the first streamed token",
+                                                  NULL, 0), timer_elapsed_ms(req->start_ns) / 1000.0);
+            if (buffer_append(&req->content, piece, len) == 0) scan_content(req, piece, len);
+        }
+        free(piece);
+    }
+}
+
+// Picks the move and explanation out of a finished reply, once
+static void parse_reply(OpenAIRequest *req) {
+    if (req->parsed) return;
+    req->parsed = 1;
+    req->expl_done = 1;
+    if (req->result != CURLE_OK || !req->response.data) return;
     
-    snprintf(prompt, sizeof(prompt),
-        "Explain in 1-2 sentences why playing '%c' at position %d "
-        "is a good move in this Tic-Tac-Toe board: %s (positions 0-8).",
-        player, move, board_str);
+    if (req->streamed) {
+        // Everything was read on the way; settle what the stream left open
+        if (req->move < 0 && req->ask != ASK_EXPLANATION && req->content.data) {
+            int mv = req->ask == ASK_TURN ? parse_turn_move(req->content.data, req->board)
+                                          : parse_move(req->content.data, req->board);
+            if (mv >= 0) set_move(req, mv);
+        }
+        return;
+    }
+    
+    // The server answered with one JSON body instead of events
+    char *content = reply_content(req->response.data);
+    const char *text = content ? content : req->response.data;
+    char *expl = NULL;
+    int mv = -1;
+    switch (req->ask) {
+    case ASK_MOVE:
+        mv = parse_move(text, req->board);
+        break;
+    case ASK_TURN:
+        mv = parse_turn_move(text, req->board);
+        if (content) expl = json_string_field(content, "explanation");
+        break;
+    case ASK_EXPLANATION:
+        expl = content;
+        content = NULL;
+        break;
+    }
+    if (req->move < 0 && mv >= 0) set_move(req, mv);
+    if (expl) buffer_append(&req->explanation, expl, strlen(expl));
+    free(expl);
+    free(content);
+    deliver(req);
+}
+
+// Frees a cancelled request that was left to finish
+static void reap_orphan(OpenAIRequest *req) {
+    OpenAIRequest **link = &client.orphans;
+    while (*link && *link != req) link = &(*link)->next_orphan;
+    if (*link) *link = req->next_orphan;
+    curl_multi_remove_handle(client.multi, req->curl);
+    request_free(req);
+    free(req);
+}
+
+// Advances every transfer in flight and marks the finished ones
+static void pump(void) {
+    if (!client.multi) return;
+    int running;
+    curl_multi_perform(client.multi, &running);
+    
+    // Completions may belong to any request in flight
+    CURLMsg *msg;
+    int queued;
+    while ((msg = curl_multi_info_read(client.multi, &queued))) {
+        if (msg->msg != CURLMSG_DONE) continue;
+        char *owner = NULL;
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &owner);
+        OpenAIRequest *done = (OpenAIRequest *)owner;
+        done->done = 1;
+        done->result = msg->data.result;
+        record_result(done, done->result);
+        if (done->orphaned) reap_orphan(done);
+    }
+}
+
+OpenAIStatus openai_move_poll(OpenAIRequest *req, int *move) {
+    if (req->move < 0 && !req->done) pump();
+    if (req->done) parse_reply(req);
+    if (req->move >= 0) {
+        *move = req->move;
+        return OPENAI_DONE;
+    }
+    return req->done ? OPENAI_FAILED : OPENAI_PENDING;
+}
+
+OpenAIStatus openai_explanation_poll(OpenAIRequest *req, const char **text) {
+    if (!req->expl_done && !req->done) pump();
+    if (req->done) parse_reply(req);
+    if (!req->expl_done) return OPENAI_PENDING;
+    if (req->explanation.size == 0) return OPENAI_FAILED;
+    *text = req->explanation.data;
+    return OPENAI_DONE;
+}
+
+void openai_on_explanation(OpenAIRequest *req, OpenAITextFn fn, void *user) {
+    req->on_text = fn;
+    req->on_text_user = user;
+    deliver(req);
+}
+
+void openai_wait(int timeout_ms) {
+    if (!client.multi) return;
+    curl_multi_poll(client.multi, NULL, 0, timeout_ms, NULL);
+    // Nothing may poll again while only cancelled requests are left running
+    if (client.orphans) pump();
+}
+
+void openai_move_cancel(OpenAIRequest *req) {
+    if (!req) return;
+    if (req->curl && !req->done && req->ask == ASK_MOVE && req->move >= 0) {
+        // A bare digit has arrived, so the stream is all but over: let it finish
+        // in the background rather than drop the connection it is using
+        req->on_text = NULL;
+        req->orphaned = 1;
+        req->next_orphan = client.orphans;
+        client.orphans = req;
+        return;
+    }
+    if (req->curl) curl_multi_remove_handle(client.multi, req->curl);
+    request_free(req);
+    free(req);
+}
+
+char* openai_explain_move(const char board[9], int move, char player) {
+    char prompt[512];
+    build_explain_prompt(board, move, player, prompt, sizeof(prompt));
     
     char *response = call_openai(prompt);
     if (!response) {
         return strdup("AI is thinking about this move.");
     }
     
-    // Extract content from JSON (simple parsing)
-    char *content_start = strstr(response, "\"content\":");
-    if (content_start) {
-        content_start = strchr(content_start, '"');
-        if (content_start) {
-            content_start++; // Skip opening quote
-            char *content_end = strchr(content_start + 1, '"');
-            if (content_end) {
-                size_t len = content_end - content_start;
-                char *result = malloc(len + 1);
-                if (result) {
-                    strncpy(result, content_start, len);
-                    result[len] = '\0';
-                    free(response);
-                    return result;
-                }
-            }
-        }
+    char *content = reply_content(response);
+    if (content) {
+        free(response);
+        return content;
     }
-    
     return response;
-}
\ No newline at end of file
+}
@@ -1,12 +1,93 @@
 #ifndef OPENAI_AI_H
 #define OPENAI_AI_H
 
-/* Initialize OpenAI client with API key */
+#include "llm_cache.h"
+
+/* Initialize OpenAI client with API key; OPENAI_MODEL overrides the default model and
+   OPENAI_BASE_URL the default server */
 int openai_init(const char *api_key);
 
+/* Server to talk to, up to but not including /chat/completions
+   (default https://api.openai.com/v1), e.g. a local mock_llm_server */
+void openai_set_base_url(const char *url);
+
+/* Give up on openai_get_move / openai_explain_move after `timeout_ms` (<= 0 for 30 s) */
+void openai_set_timeout(int timeout_ms);
+
+/* Model named in requests (default gpt-3.5-turbo) */
+void openai_set_model(const char *name);
+const char *openai_model(void);
+
+/* Answer repeated positions from a cache of earlier move replies, kept in the file at
+   `path` (NULL for memory only). Answers expire after `ttl_seconds` (<= 0 for never)
+   and are kept apart per model, so switching models starts afresh. */
+int openai_enable_cache(const char *path, long ttl_seconds);
+
+/* Hit and miss counts of the move cache; -1 if it is not enabled */
+int openai_cache_stats(LlmCacheStats *stats);
+
 /* Get best move using OpenAI API */
 int openai_get_move(const char board[9], char player, char opponent);
 
+/* Where the time of one request went. A request on a reused connection has no
+   connect or TLS time. */
+typedef struct {
+    double dns_ms;          /* name lookup */
+    double connect_ms;      /* TCP connect */
+    double tls_ms;          /* TLS handshake */
+    double ttfb_ms;         /* from start to the first response byte */
+    double total_ms;
+    double move_ms;         /* from start until the move was read, often mid-stream */
+    int reused;             /* non-zero if an open connection was reused */
+    int cached;             /* non-zero if the move came from the move cache */
+    int guessed;            /* non-zero if the reply named no legal move, so
+                               openai_get_move played the first empty cell */
+} OpenAITimings;
+
+/* Timings of the latest openai_get_move / openai_explain_move call */
+void openai_last_timings(OpenAITimings *t);
+
+/* A move request running in the background */
+typedef struct OpenAIRequest OpenAIRequest;
+
+typedef enum { OPENAI_PENDING, OPENAI_DONE, OPENAI_FAILED } OpenAIStatus;
+
+/* Start asking for a move without waiting for the network. The reply is streamed and
+   the move taken as soon as it appears. The transfer is abandoned
+   after `timeout_ms` (<= 0 for 30 s). Returns NULL if it could not be started. */
+OpenAIRequest *openai_move_start(const char board[9], char player, char opponent, int timeout_ms);
+
+/* Advance all requests in flight without blocking. OPENAI_DONE stores a legal move in
+   `*move`; OPENAI_FAILED means an error, a timeout or a reply without a legal move. */
+OpenAIStatus openai_move_poll(OpenAIRequest *req, int *move);
+
+/* Start asking for a move together with an explanation of it, in one request whose
+   reply names the move first. Poll the move with openai_move_poll and the text with
+   openai_explanation_poll; on a cache hit the move is ready at once and only the
+   explanation goes to the network. */
+OpenAIRequest *openai_turn_start(const char board[9], char player, char opponent, int timeout_ms);
+
+/* Advance all requests in flight without blocking. OPENAI_DONE points `*text` at the
+   explanation, valid until the request is cancelled; OPENAI_FAILED means there is none. */
+OpenAIStatus openai_explanation_poll(OpenAIRequest *req, const char **text);
+
+/* Called with each piece of explanation text as it streams in; `text` is not
+   NUL-terminated */
+typedef void (*OpenAITextFn)(const char *text, size_t len, void *user);
+
+/* Pass the explanation to `fn` piece by piece as it arrives, starting with what
+   has arrived already. Pieces are only delivered while polling or waiting. */
+void openai_on_explanation(OpenAIRequest *req, OpenAITextFn fn, void *user);
+
+/* Sleep until a request in flight has news or `timeout_ms` passes */
+void openai_wait(int timeout_ms);
+
+/* Timings of a request once its reply has arrived */
+void openai_move_timings(const OpenAIRequest *req, OpenAITimings *t);
+
+/* Abort the request if it is still running and free it; call once per started request */
+void openai_move_cancel(OpenAIRequest *req);
+
 /* Get move explanation from OpenAI */
 char* openai_explain_move(const char board[9], int move, char player);
 
@@ -0,0 +1,202 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "game.h"
+#include "ai.h"
+#include "openai_ai.h"
+#include "timer.h"
+
+/* Latency benchmark of the OpenAI code path, meant to run against
+   mock_llm_server (see `make openai-bench`) so no money or network is
+   spent.
+
+   Usage: openai_bench [--url URL] [--turns N] [--deadline MS] [--timeout MS]
+                       [--frame-ms MS] [--seed S]
+
+   Each scenario plays N turns on random mid-game positions:
+     get_move      openai_get_move, blocking, the request timed out after
+                   --timeout; a failure, or a reply naming no legal move,
+                   falls back to the local AI
+     explain       openai_explain_move, blocking; falls back when it
+                   returns its placeholder text
+     gui_turn      the turn logic of gui_tictactoe_openai: a request polled
+                   once per frame, the local AI moving if it fails or takes
+                   longer than --deadline
+     console_turn  the turn of tictactoe-openai: one request for the move
+                   and its explanation; latency is until the move is known
+
+   Reports p50 / p95 / p99 / max turn latency and the share of turns that
+   fell back. The GUI's deliberate think pause is not included. */
+
+#define PLACEHOLDER "AI is thinking about this move."
+
+typedef struct {
+    const char *name;
+    double *ms;
+    int count, fallbacks;
+} Scenario;
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile(const double *sorted, int n, double p) {
+    int i = (int)(p * (n - 1) + 0.5);
+    return sorted[i];
+}
+
+static unsigned xorshift(unsigned *state) {
+    unsigned x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+/* A position 0-6 random plies in with the game still open; returns the side to move */
+static char random_position(char board[9], unsigned *rng) {
+    for (;;) {
+        init_board(board);
+        int plies = (int)(xorshift(rng) % 7);
+        char turn = 'X';
+        for (int p = 0; p < plies; ++p) {
+            int empty[9], n = 0;
+            for (int i = 0; i < 9; ++i)
+                if (board[i] == ' ') empty[n++] = i;
+            board[empty[xorshift(rng) % (unsigned)n]] = turn;
+            turn = (turn == 'X') ? 'O' : 'X';
+        }
+        if (check_winner(board) == ' ') return turn;
+    }
+}
+
+static void run_get_move(Scenario *s, const char board[9], char me, char other) {
+    uint64_t start = timer_now_ns();
+    int mv = openai_get_move(board, me, other);
+    OpenAITimings t;
+    openai_last_timings(&t);
+    if (mv < 0 || board[mv] != ' ' || t.guessed) {
+        s->fallbacks++;
+        mv = get_best_move(board, me, other);
+    }
+    s->ms[s->count++] = timer_elapsed_ms(start);
+}
+
+static void run_explain(Scenario *s, const char board[9], char me, char other) {
+    int mv = get_best_move(board, me, other);
+    uint64_t start = timer_now_ns();
+    char *text = openai_explain_move(board, mv, me);
+    if (!text || strcmp(text, PLACEHOLDER) == 0) s->fallbacks++;
+    s->ms[s->count++] = timer_elapsed_ms(start);
+    free(text);
+}
+
+static void run_gui_turn(Scenario *s, const char board[9], char me, char other, int deadline_ms, int frame_ms) {
+    uint64_t start = timer_now_ns();
+    OpenAIRequest *req = openai_move_start(board, me, other, deadline_ms);
+    int mv = -1;
+    for (;;) {
+        OpenAIStatus st = req ? openai_move_poll(req, &mv) : OPENAI_FAILED;
+        if (st == OPENAI_DONE) break;
+        if (st == OPENAI_FAILED || timer_elapsed_ms(start) >= deadline_ms) {
+            s->fallbacks++;
+            mv = get_best_move(board, me, other);
+            break;
+        }
+        openai_wait(frame_ms);
+    }
+    s->ms[s->count++] = timer_elapsed_ms(start);
+    openai_move_cancel(req);
+}
+
+static void run_console_turn(Scenario *s, const char board[9], char me, char other, int timeout_ms) {
+    uint64_t start = timer_now_ns();
+    OpenAIRequest *req = openai_turn_start(board, me, other, timeout_ms);
+    int mv = -1;
+    OpenAIStatus st = OPENAI_FAILED;
+    if (req) {
+        while ((st = openai_move_poll(req, &mv)) == OPENAI_PENDING) openai_wait(100);
+    }
+    if (st != OPENAI_DONE) {
+        s->fallbacks++;
+        mv = get_best_move(board, me, other);
+    }
+    s->ms[s->count++] = timer_elapsed_ms(start);
+    openai_move_cancel(req);
+}
+
+static void report(Scenario *s) {
+    if (s->count == 0) return;
+    qsort(s->ms, (size_t)s->count, sizeof(double), cmp_double);
+    printf("%-13s %6d %9.1f %9.1f %9.1f %9.1f %8.1f%%\n", s->name, s->count,
+           percentile(s->ms, s->count, 0.50), percentile(s->ms, s->count, 0.95),
+           percentile(s->ms, s->count, 0.99), s->ms[s->count - 1], 100.0 * s->fallbacks / s->count);
+}
+
+static int usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [--url URL] [--turns N] [--deadline MS] [--timeout MS] [--frame-ms MS] [--seed S]\n",
+            prog);
+    return 2;
+}
+
+int main(int argc, char **argv) {
+    const char *url = "http://127.0.0.1:8089/v1";
+    int turns = 200, deadline_ms = 8000, timeout_ms = 8000, frame_ms = 16;
+    unsigned seed = 1u;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--url") && i + 1 < argc) url = argv[++i];
+        else if (!strcmp(argv[i], "--turns") && i + 1 < argc) turns = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--deadline") && i + 1 < argc) deadline_ms = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--timeout") && i + 1 < argc) timeout_ms = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--frame-ms") && i + 1 < argc) frame_ms = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = (unsigned)strtoul(argv[++i], NULL, 10);
+        else return usage(argv[0]);
+    }
+    if (turns < 1 || deadline_ms < 1 || timeout_ms < 1 || frame_ms < 1) return usage(argv[0]);
+    if (seed == 0) seed = 1;
+
+    if (openai_init("mock-key") != 0) return 1;
+    openai_set_base_url(url);
+    openai_set_timeout(timeout_ms);
+
+    Scenario scenarios[] = {
+        { "get_move", NULL, 0, 0 },
+        { "explain", NULL, 0, 0 },
+        { "gui_turn", NULL, 0, 0 },
+        { "console_turn", NULL, 0, 0 },
+    };
+    const int count = (int)(sizeof(scenarios) / sizeof(scenarios[0]));
+    for (int k = 0; k < count; ++k) {
+        scenarios[k].ms = malloc((size_t)turns * sizeof(double));
+        if (!scenarios[k].ms) return 1;
+    }
+
+    printf("OpenAI path against %s: %d turns per scenario, deadline %d ms, timeout %d ms\n",
+           url, turns, deadline_ms, timeout_ms);
+    uint64_t start = timer_now_ns();
+    for (int k = 0; k < count; ++k) {
+        /* Same positions for every scenario */
+        unsigned rng = seed;
+        for (int t = 0; t < turns; ++t) {
+            char board[9];
+            char me = random_position(board, &rng);
+            char other = (me == 'X') ? 'O' : 'X';
+            switch (k) {
+            case 0: run_get_move(&scenarios[k], board, me, other); break;
+            case 1: run_explain(&scenarios[k], board, me, other); break;
+            case 2: run_gui_turn(&scenarios[k], board, me, other, deadline_ms, frame_ms); break;
+            default: run_console_turn(&scenarios[k], board, me, other, timeout_ms); break;
+            }
+        }
+    }
+
+    printf("%-13s %6s %9s %9s %9s %9s %9s\n", "scenario", "turns", "p50 ms", "p95 ms", "p99 ms", "max ms", "fallback");
+    for (int k = 0; k < count; ++k) {
+        report(&scenarios[k]);
+        free(scenarios[k].ms);
+    }
+    printf("%.1f s total\n", timer_elapsed_ms(start) / 1000.0);
+    openai_cleanup();
+    return 0;
+}
@@ -0,0 +1,161 @@
+#include "ponder.h"
+#include "game.h"
+#include "metrics.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* One worker thread searches the replies to the candidate moves in order.
+   Each job is tagged with the generation it belongs to; starting, taking
+   or stopping bumps the generation, and results of an older one are
+   dropped. A search is never interrupted, but a 3x3 search is short. */
+
+enum { REPLY_TODO, REPLY_RUNNING, REPLY_DONE };
+
+typedef struct {
+    int state;
+    int move;               /* -1 if the human's move ends the game */
+    SearchStats stats;
+} Reply;
+
+struct Ponder {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;    /* new work, finished replies and quitting */
+    int quit;
+    int active;             /* a position is being pondered */
+    unsigned generation;
+    char board[9];          /* human to move */
+    char ai, human;
+    int order[9], count, next;
+    Reply reply[9];         /* by the human's move */
+};
+
+int ponder_candidates(const char board[9], char human, char ai, int moves[9]) {
+    static const int rank[9] = { 1, 0, 1, 0, 2, 0, 1, 0, 1 };  /* center, corners, edges */
+    int score[9], n = 0;
+    char b[9];
+    memcpy(b, board, 9);
+    for (int i = 0; i < 9; ++i) {
+        if (b[i] != ' ') continue;
+        b[i] = human;
+        int s = rank[i] + (check_winner(b) == human ? 8 : 0);
+        b[i] = ai;
+        s += (check_winner(b) == ai) ? 4 : 0;
+        b[i] = ' ';
+        /* insertion sort, stable so equal cells keep board order */
+        int j = n++;
+        for (; j > 0 && score[j - 1] < s; --j) {
+            score[j] = score[j - 1];
+            moves[j] = moves[j - 1];
+        }
+        score[j] = s;
+        moves[j] = i;
+    }
+    return n;
+}
+
+static void *ponder_main(void *arg) {
+    Ponder *p = arg;
+    pthread_mutex_lock(&p->lock);
+    for (;;) {
+        while (!p->quit && !(p->active && p->next < p->count)) pthread_cond_wait(&p->cond, &p->lock);
+        if (p->quit) break;
+
+        int cell = p->order[p->next++];
+        unsigned generation = p->generation;
+        char board[9], ai = p->ai, human = p->human;
+        memcpy(board, p->board, 9);
+        board[cell] = human;
+        p->reply[cell].state = REPLY_RUNNING;
+        pthread_mutex_unlock(&p->lock);
+
+        Reply r = { REPLY_DONE, -1, { 0, 0, 0, 0, 0, 0.0 } };
+        if (check_winner(board) == ' ') r.move = get_best_move_ex(board, ai, human, &r.stats);
+
+        pthread_mutex_lock(&p->lock);
+        if (generation == p->generation) {
+            p->reply[cell] = r;
+            pthread_cond_broadcast(&p->cond);
+        }
+    }
+    pthread_mutex_unlock(&p->lock);
+    return NULL;
+}
+
+Ponder *ponder_create(void) {
+    Ponder *p = calloc(1, sizeof(Ponder));
+    if (!p) return NULL;
+    pthread_mutex_init(&p->lock, NULL);
+    pthread_cond_init(&p->cond, NULL);
+    if (pthread_create(&p->thread, NULL, ponder_main, p) != 0) {
+        pthread_cond_destroy(&p->cond);
+        pthread_mutex_destroy(&p->lock);
+        free(p);
+        return NULL;
+    }
+    return p;
+}
+
+void ponder_start(Ponder *p, const char board[9], char ai, char human) {
+    pthread_mutex_lock(&p->lock);
+    p->generation++;
+    memcpy(p->board, board, 9);
+    p->ai = ai;
+    p->human = human;
+    p->count = ponder_candidates(board, human, ai, p->order);
+    p->next = 0;
+    for (int i = 0; i < 9; ++i) p->reply[i].state = REPLY_TODO;
+    p->active = 1;
+    pthread_cond_broadcast(&p->cond);
+    pthread_mutex_unlock(&p->lock);
+}
+
+int ponder_take(Ponder *p, const char board[9], int *move, SearchStats *stats) {
+    int hit = 0;
+    pthread_mutex_lock(&p->lock);
+    if (p->active) {
+        /* The human's move is the one cell that changed */
+        int cell = -1, diffs = 0;
+        for (int i = 0; i < 9; ++i) {
+            if (board[i] == p->board[i]) continue;
+            ++diffs;
+            if (p->board[i] == ' ' && board[i] == p->human) cell = i;
+        }
+        if (diffs == 1 && cell >= 0) {
+            while (p->reply[cell].state == REPLY_RUNNING) pthread_cond_wait(&p->cond, &p->lock);
+            const Reply *r = &p->reply[cell];
+            if (r->state == REPLY_DONE && r->move >= 0) {
+                *move = r->move;
+                if (stats) *stats = r->stats;
+                hit = 1;
+            }
+        }
+    }
+    p->active = 0;
+    p->generation++;
+    pthread_mutex_unlock(&p->lock);
+
+    if (hit) metrics_add(metrics_counter("ponder_hits_total", "AI replies ready when the human moved"), 1);
+    else metrics_add(metrics_counter("ponder_misses_total", "AI replies searched after the human moved"), 1);
+    return hit;
+}
+
+void ponder_stop(Ponder *p) {
+    pthread_mutex_lock(&p->lock);
+    p->active = 0;
+    p->generation++;
+    pthread_mutex_unlock(&p->lock);
+}
+
+void ponder_destroy(Ponder *p) {
+    if (!p) return;
+    pthread_mutex_lock(&p->lock);
+    p->quit = 1;
+    pthread_cond_broadcast(&p->cond);
+    pthread_mutex_unlock(&p->lock);
+    pthread_join(p->thread, NULL);
+    pthread_cond_destroy(&p->cond);
+    pthread_mutex_destroy(&p->lock);
+    free(p);
+}
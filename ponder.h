@@ -0,0 +1,33 @@
+#ifndef PONDER_H
+#define PONDER_H
+
+#include "ai.h"
+
+/* Pondering: while the human thinks, a background thread works out the AI's
+   reply to each move the human might make, most likely first, so the real
+   reply is usually ready the moment the human moves. */
+
+typedef struct Ponder Ponder;
+
+/* The empty cells of `board` ordered by how likely `human` is to play them:
+   wins, then blocks of `ai`, then center, corners and edges. Returns how many. */
+int ponder_candidates(const char board[9], char human, char ai, int moves[9]);
+
+/* Starts the pondering thread; NULL if it could not be started */
+Ponder *ponder_create(void);
+
+/* Begins working on `board`, where `human` is to move. Drops earlier work. */
+void ponder_start(Ponder *p, const char board[9], char ai, char human);
+
+/* Ends pondering with `board` as the position after the human's move. Returns 1 and
+   stores the reply in `*move` (and its cost in `stats`, which may be NULL) if it was
+   worked out; waits for it if it is being searched right now. Returns 0 otherwise. */
+int ponder_take(Ponder *p, const char board[9], int *move, SearchStats *stats);
+
+/* Drops all work, e.g. when the game is abandoned */
+void ponder_stop(Ponder *p);
+
+/* Stops the thread and frees `p` (may be NULL) */
+void ponder_destroy(Ponder *p);
+
+#endif /* PONDER_H */
@@ -0,0 +1,28 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 199309L
+#endif
+#include "timer.h"
+
+#ifdef _WIN32
+#include <windows.h>
+
+uint64_t timer_now_ns(void) {
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+    if (freq.QuadPart == 0) QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (uint64_t)((double)now.QuadPart * 1e9 / (double)freq.QuadPart);
+}
+#else
+#include <time.h>
+
+uint64_t timer_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+#endif
+
+double timer_elapsed_ms(uint64_t start_ns) {
+    return (double)(timer_now_ns() - start_ns) / 1e6;
+}
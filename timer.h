@@ -0,0 +1,12 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <stdint.h>
+
+/* Monotonic wall-clock time in nanoseconds, from an arbitrary origin */
+uint64_t timer_now_ns(void);
+
+/* Milliseconds elapsed since `start_ns` (a timer_now_ns value) */
+double timer_elapsed_ms(uint64_t start_ns);
+
+#endif /* TIMER_H */
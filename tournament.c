@@ -0,0 +1,317 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "game.h"
+#include "ai.h"
+#include "mnk_ai.h"
+#include "mcts_ai.h"
+#include "timer.h"
+
+/* Self-play tournament between two move sources, played on worker threads.
+
+   Usage: tournament A B [--games N] [--threads N] [--opening-plies K] [--seed S]
+
+   Sources:
+     perfect        get_best_move
+     random         a uniformly random legal move
+     depth:N        get_best_move_depth, N plies of lookahead
+     noisy:P        perfect play, but a random move with probability P
+     mnk            mnk_get_best_move, the m,n,k engine on a 3,3,3 board
+     mnk:N          mnk_get_best_move_depth, N plies of lookahead
+     mcts:P         mcts_get_best_move with P playouts per move, from a fresh
+                    tree each move; its moves are made one at a time, so
+                    extra threads do not speed it up
+     recorded:FILE  moves from FILE, lines "<position> <move> ..." as written
+                    by `tictactoe --batch`; unlisted positions take the first
+                    empty cell
+
+   Games come in pairs that share a random opening of K plies with the
+   colors swapped, so neither side profits from a lucky opening. */
+
+typedef enum { SRC_PERFECT, SRC_RANDOM, SRC_DEPTH, SRC_NOISY, SRC_RECORDED, SRC_MNK, SRC_MCTS } SourceKind;
+
+typedef struct {
+    SourceKind kind;
+    const char *spec;
+    int depth;              /* SRC_DEPTH, SRC_MNK (0 = mnk_get_best_move); SRC_MCTS: playouts */
+    double noise;
+    signed char *moves;     /* SRC_RECORDED: move per base-3 board code, -1 if none */
+} Source;
+
+typedef struct {
+    const Source *a, *b;
+    long games;
+    int opening_plies;
+    unsigned seed;
+    long next_pair;         /* shared; claimed atomically */
+} Tournament;
+
+typedef struct {
+    Tournament *t;
+    long wins, draws, losses;   /* for A */
+    long missing;               /* recorded lookups that fell back */
+} Worker;
+
+static unsigned xorshift(unsigned *state) {
+    unsigned x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+static int board_code(const char board[9]) {
+    int code = 0;
+    for (int i = 8; i >= 0; --i)
+        code = code * 3 + (board[i] == 'X' ? 1 : board[i] == 'O' ? 2 : 0);
+    return code;
+}
+
+static int random_move(const char board[9], unsigned *rng) {
+    int empty[9], n = 0;
+    for (int i = 0; i < 9; ++i)
+        if (board[i] == ' ') empty[n++] = i;
+    return empty[xorshift(rng) % (unsigned)n];
+}
+
+/* The MCTS engine keeps one tree and configuration for the process, so
+   its moves are made one at a time. The tree is dropped before each, so a
+   move depends only on the position and not on the games before it. */
+static pthread_mutex_t mcts_lock = PTHREAD_MUTEX_INITIALIZER;
+static int mcts_playouts;   /* configured; 0 before the first move */
+
+static int mcts_move(int playouts, const char board[9], char me, char other) {
+    pthread_mutex_lock(&mcts_lock);
+    if (mcts_playouts != playouts) {
+        MctsConfig cfg;
+        mcts_default_config(&cfg);
+        cfg.playouts = playouts;
+        if (mcts_configure(&cfg) == 0) mcts_playouts = playouts;
+    }
+    MnkBoard b;
+    mnk_from_board(&b, board);
+    mcts_reset();
+    int mv = mcts_get_best_move(&b, me, other);
+    pthread_mutex_unlock(&mcts_lock);
+    return mv;
+}
+
+static int source_move(const Source *s, const char board[9], char me, char other,
+                       unsigned *rng, long *missing) {
+    switch (s->kind) {
+    case SRC_RANDOM:
+        return random_move(board, rng);
+    case SRC_DEPTH:
+        return get_best_move_depth(board, me, other, s->depth);
+    case SRC_NOISY:
+        if ((xorshift(rng) & 0xFFFFFF) < s->noise * 0x1000000) return random_move(board, rng);
+        return get_best_move(board, me, other);
+    case SRC_MNK: {
+        MnkBoard b;
+        mnk_from_board(&b, board);
+        return s->depth ? mnk_get_best_move_depth(&b, me, other, s->depth) : mnk_get_best_move(&b, me, other);
+    }
+    case SRC_MCTS:
+        return mcts_move(s->depth, board, me, other);
+    case SRC_RECORDED: {
+        int mv = s->moves[board_code(board)];
+        if (mv >= 0 && board[mv] == ' ') return mv;
+        ++*missing;
+        for (int i = 0; i < 9; ++i)
+            if (board[i] == ' ') return i;
+        return 0;
+    }
+    case SRC_PERFECT:
+    default:
+        return get_best_move(board, me, other);
+    }
+}
+
+/* Plays one game after `opening` random plies; `a_plays` is A's symbol.
+   Returns 1 if A wins, 0 for a draw, -1 if A loses. */
+static int play_game(Worker *w, char a_plays, unsigned opening_seed, unsigned *rng) {
+    const Tournament *t = w->t;
+    char board[9];
+    init_board(board);
+    char turn = 'X';
+    char winner = ' ';
+    for (int ply = 0; winner == ' '; ++ply) {
+        char other = (turn == 'X') ? 'O' : 'X';
+        int mv;
+        if (ply < t->opening_plies) mv = random_move(board, &opening_seed);
+        else mv = source_move(turn == a_plays ? t->a : t->b, board, turn, other, rng, &w->missing);
+        board[mv] = turn;
+        winner = check_winner(board);
+        turn = other;
+    }
+    if (winner == 'T') return 0;
+    return winner == a_plays ? 1 : -1;
+}
+
+static void *worker_main(void *arg) {
+    Worker *w = arg;
+    Tournament *t = w->t;
+    long pairs = (t->games + 1) / 2;
+    for (;;) {
+        long pair = __atomic_fetch_add(&t->next_pair, 1, __ATOMIC_RELAXED);
+        if (pair >= pairs) break;
+        /* Seeds depend only on the pair, so results do not depend on threading */
+        unsigned opening = t->seed ^ (unsigned)(pair * 2654435761u);
+        if (opening == 0) opening = 1;
+        for (int g = 0; g < 2 && pair * 2 + g < t->games; ++g) {
+            unsigned rng = opening * 40503u + (unsigned)g + 1u;
+            if (rng == 0) rng = 1;
+            int r = play_game(w, g == 0 ? 'X' : 'O', opening, &rng);
+            if (r > 0) w->wins++;
+            else if (r < 0) w->losses++;
+            else w->draws++;
+        }
+    }
+    return NULL;
+}
+
+static int load_recorded(Source *s, const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return -1;
+    }
+    s->moves = malloc(19683);
+    if (!s->moves) {
+        fclose(f);
+        return -1;
+    }
+    memset(s->moves, -1, 19683);
+    char line[128];
+    while (fgets(line, sizeof(line), f)) {
+        char board[9];
+        int ok = 1;
+        for (int i = 0; i < 9 && ok; ++i) {
+            if (line[i] == 'X' || line[i] == 'O') board[i] = line[i];
+            else if (line[i] == '-') board[i] = ' ';
+            else ok = 0;
+        }
+        if (ok && line[9] == ' ' && line[10] >= '0' && line[10] <= '8')
+            s->moves[board_code(board)] = (signed char)(line[10] - '0');
+    }
+    fclose(f);
+    return 0;
+}
+
+static int parse_source(const char *spec, Source *s) {
+    memset(s, 0, sizeof(*s));
+    s->spec = spec;
+    if (strcmp(spec, "perfect") == 0) {
+        s->kind = SRC_PERFECT;
+    } else if (strcmp(spec, "random") == 0) {
+        s->kind = SRC_RANDOM;
+    } else if (strncmp(spec, "depth:", 6) == 0) {
+        s->kind = SRC_DEPTH;
+        s->depth = atoi(spec + 6);
+        if (s->depth < 1) return -1;
+    } else if (strcmp(spec, "mnk") == 0) {
+        s->kind = SRC_MNK;
+    } else if (strncmp(spec, "mnk:", 4) == 0) {
+        s->kind = SRC_MNK;
+        s->depth = atoi(spec + 4);
+        if (s->depth < 1) return -1;
+    } else if (strncmp(spec, "mcts:", 5) == 0) {
+        s->kind = SRC_MCTS;
+        s->depth = atoi(spec + 5);
+        if (s->depth < 1) return -1;
+    } else if (strncmp(spec, "noisy:", 6) == 0) {
+        s->kind = SRC_NOISY;
+        s->noise = atof(spec + 6);
+        if (s->noise < 0 || s->noise > 1) return -1;
+    } else if (strncmp(spec, "recorded:", 9) == 0) {
+        s->kind = SRC_RECORDED;
+        return load_recorded(s, spec + 9);
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+/* 95% Wilson score interval for k successes in n trials */
+static void wilson(long k, long n, double *lo, double *hi) {
+    const double z = 1.96;
+    if (n == 0) {
+        *lo = 0;
+        *hi = 1;
+        return;
+    }
+    double p = (double)k / n, z2n = z * z / n;
+    double center = (p + z2n / 2) / (1 + z2n);
+    double half = z * sqrt(p * (1 - p) / n + z2n / (4.0 * n)) / (1 + z2n);
+    *lo = center - half;
+    *hi = center + half;
+}
+
+static int usage(const char *prog) {
+    fprintf(stderr, "Usage: %s A B [--games N] [--threads N] [--opening-plies K] [--seed S]\n"
+                    "Sources: perfect, random, depth:N, noisy:P, mnk, mnk:N, mcts:P, recorded:FILE\n", prog);
+    return 2;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) return usage(argv[0]);
+    Source a, b;
+    if (parse_source(argv[1], &a) != 0 || parse_source(argv[2], &b) != 0) return usage(argv[0]);
+
+    Tournament t = { &a, &b, 10000, 2, 1u, 0 };
+    int threads = 4;
+    for (int i = 3; i < argc; ++i) {
+        if (!strcmp(argv[i], "--games") && i + 1 < argc) t.games = atol(argv[++i]);
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--opening-plies") && i + 1 < argc) t.opening_plies = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc) t.seed = (unsigned)strtoul(argv[++i], NULL, 10);
+        else return usage(argv[0]);
+    }
+    if (t.games < 1 || threads < 1 || t.opening_plies < 0 || t.opening_plies > 8) return usage(argv[0]);
+    if (threads > 64) threads = 64;
+
+    Worker workers[64];
+    pthread_t tids[64];
+    memset(workers, 0, sizeof(workers));
+    uint64_t start = timer_now_ns();
+    int started = 0;
+    for (int i = 0; i < threads; ++i) workers[i].t = &t;
+    for (int i = 1; i < threads; ++i) {
+        if (pthread_create(&tids[i], NULL, worker_main, &workers[i]) != 0) break;
+        started++;
+    }
+    worker_main(&workers[0]);
+    for (int i = 1; i <= started; ++i) pthread_join(tids[i], NULL);
+    double secs = timer_elapsed_ms(start) / 1000.0;
+
+    long w = 0, d = 0, l = 0, missing = 0;
+    for (int i = 0; i < threads; ++i) {
+        w += workers[i].wins;
+        d += workers[i].draws;
+        l += workers[i].losses;
+        missing += workers[i].missing;
+    }
+    long n = w + d + l;
+    double lo, hi;
+
+    printf("%s vs %s: %ld games, %d opening plies, %d threads\n", a.spec, b.spec, n, t.opening_plies, threads);
+    wilson(w, n, &lo, &hi);
+    printf("  %-6s %9ld  %6.2f%%  [%6.2f%%, %6.2f%%]\n", "win", w, 100.0 * w / n, 100 * lo, 100 * hi);
+    wilson(d, n, &lo, &hi);
+    printf("  %-6s %9ld  %6.2f%%  [%6.2f%%, %6.2f%%]\n", "draw", d, 100.0 * d / n, 100 * lo, 100 * hi);
+    wilson(l, n, &lo, &hi);
+    printf("  %-6s %9ld  %6.2f%%  [%6.2f%%, %6.2f%%]\n", "loss", l, 100.0 * l / n, 100 * lo, 100 * hi);
+
+    /* Score of A per game (1 / 0.5 / 0) with a normal 95% interval */
+    double mean = (w + 0.5 * d) / n;
+    double var = (w * (1 - mean) * (1 - mean) + d * (0.5 - mean) * (0.5 - mean) + l * mean * mean) / n;
+    printf("  score  %.4f +/- %.4f\n", mean, 1.96 * sqrt(var / n));
+    if (missing) printf("  %ld positions missing from recorded moves\n", missing);
+    printf("  %.3f s, %.0f games/sec\n", secs, n / secs);
+
+    free(a.moves);
+    free(b.moves);
+    return 0;
+}